@@ -1,4 +1,5 @@
 #include "SI4735.h"
+#include "patch_init.h" // SSB patch for whole SSBRX initialization string (only this file includes it: one definition)
 
 /**********************************************************************
  * SI4735 Class definition
@@ -62,6 +63,20 @@ si47x_rqs_status currentRqsStatus;       //!<  current Radio SIgnal Quality stat
 si47x_response_status currentStatus;     //!<  current device status
 si47x_firmware_information firmwareInfo; //!<  firmware information
 si47x_rds_status currentRdsStatus;       //!<  current RDS status
+si473x_rds_info rdsInfo;                 //!<  RDS data decoded by processRdsGroup
+si473x_rds_text_vote rdsPsVote;          //!<  Character votes of rds_buffer0A
+si473x_rds_text_vote rdsRtVote;          //!<  Character votes of rdsRtWork
+char rdsRtWork[65];                      //!<  Radio Text (2A or 2B) being received; published on rds_buffer2A or rds_buffer2B
+uint8_t rdsRtAB;                         //!<  A/B flag of rdsRtWork
+uint8_t rdsRtVersion;                    //!<  Version of rdsRtWork (0 = 2A; 1 = 2B)
+uint16_t rdsFrequency;                   //!<  Frequency of the RDS data being decoded (a new one resets the decoder)
+bool rdsCacheChecked;                    //!<  The station cache was checked for the current PI
+uint16_t rdsPiCandidate;                 //!<  New PI read on a corrected block A; taken when the next group agrees
+bool rdsCacheEnabled = true;             //!<  See setRdsCache (the cache is shared by all devices)
+bool rdsGroupRemoved;                    //!<  currentRdsStatus holds a group removed from the FIFO and not decoded yet
+bool rdsAfCheck;                         //!<  processAfSwitch tuned an AF: the RDS decoder keeps the data of rdsFrequency
+si473x_rds_capture *rdsCapture = NULL;   //!<  Groups read from the device are copied here (see startRdsCapture)
+uint8_t rdsTextConfidence = RDS_TEXT_CONFIDENCE; //!<  Votes a PS/RT character needs to be shown (0 = no voting)
 si47x_agc_status currentAgcStatus;       //!<  current AGC status
 si47x_ssb_mode currentSSBMode;           //!<  indicates if USB or LSB
 
@@ -73,24 +88,128 @@ uint8_t currentAudioMode = SI473X_ANALOG_AUDIO; //!< Current audio mode used (AN
 uint8_t currentSsbStatus = 0;
 int8_t audioMuteMcuPin = -1;
 
+volatile uint8_t ctsInterruptFlag = 0;                    //!< Set by SI4735_EXTI_Callback when the device raises CTS on GPO2/INT.
+uint8_t ctsWaitMode = CTS_WAIT_POLLING;                   //!< CTS_WAIT_POLLING or CTS_WAIT_INTERRUPT.
+uint16_t minDelayWaitSendLoop = MIN_DELAY_WAIT_SEND_LOOP; //!< Polling step of waitToSend (in us).
+uint16_t maxDelayCtsInterrupt = MAX_DELAY_CTS_INTERRUPT;  //!< Max time (in ms) waitToSend waits for the CTS interrupt.
+volatile uint8_t stcInterruptFlag = 0;                    //!< Set by SI4735_EXTI_Callback; checked by waitTuneComplete.
+uint8_t stcIntEnable = 0;                                 //!< STCIEN given to setGpioIen (0 = no STC interrupt on GPO2/INT).
+uint16_t maxDelayTuneComplete = MAX_DELAY_TUNE_COMPLETE;  //!< Max time (in ms) waitTuneComplete waits for STCINT.
+
+bool tuneCoalescing = false;   //!< true = frequencyUp/frequencyDown use requestFrequency.
+uint8_t tunePending = 0;       //!< 1 = pendingTuneFrequency waits to be sent.
+uint16_t pendingTuneFrequency; //!< Latest frequency requested by requestFrequency.
+uint8_t tuneInProgress = 0;    //!< 1 = a coalescing tune was sent and STCINT was not seen yet.
+uint32_t tuneStartTime;        //!< When the coalescing tune in progress was sent.
+uint32_t lastStcPoll;          //!< When processPendingTune last read STCINT (polling mode).
+
+uint8_t scanMinRssi = SCAN_MIN_RSSI; //!< Min RSSI (dBuV) of a channel stored by scanBand.
+uint8_t scanMinSnr = SCAN_MIN_SNR;   //!< Min SNR (dB) of a channel stored by scanBand.
+
+uint8_t patchDownloadMode = PATCH_DOWNLOAD_CTS;     //!< PATCH_DOWNLOAD_CTS or PATCH_DOWNLOAD_DELAY.
+uint16_t minDelayPatchPoll = MIN_DELAY_PATCH_POLL;  //!< Polling step (in us) of the CTS check after each patch line.
+si473x_patch_result patchResult = {PATCH_RESULT_OK, -1, 0}; //!< Result of the last patch download.
+const uint8_t *residentPatch = NULL;                //!< Patch held by the device since the last reset (NULL = none).
+uint16_t residentPatchId = 0;                       //!< Patch ID (GET_REV) of residentPatch.
+bool patchRetention = false;                        //!< The device keeps its patch through POWER_DOWN (see setPatchRetention).
+uint32_t eepromPatchThroughput = 0;                 //!< Bytes per second of the last downloadPatchFromEeprom.
+uint8_t ctsReady = 0;                                     //!< 1 if CTS was seen after the last command written to the device.
+
+si473x_command commandQueue[SI473X_CMD_QUEUE_SIZE]; //!< Commands waiting to be processed by the command engine.
+volatile uint8_t commandQueueHead = 0;              //!< Index of the command being processed by the command engine.
+volatile uint8_t commandQueueTail = 0;              //!< Index where the next queued command will be stored.
+uint16_t commandTicket = 0;                         //!< Ticket of the last queued command.
+uint16_t commandDoneTicket = 0;                     //!< Ticket of the last completed command.
+uint8_t commandEngineState = 0;                     //!< 0 = idle; 1 = waiting CTS to send; 2 = sent, waiting the response.
+uint8_t commandEngineBusy = 0;                      //!< Avoids reentrance of processCommandQueue.
+uint32_t commandStartTime;                          //!< When the engine started to deal with the current command.
+si47x_status lastCommandStatus;                     //!< Status byte of the last command completed by the engine.
+
+si473x_property_cache propertyCache[SI473X_PROPERTY_CACHE_SIZE]; //!< Last value written to each property.
+uint8_t propertyCacheCount = 0;                                   //!< Entries used on propertyCache.
+uint8_t propertyCacheNext = 0;                                    //!< Entry replaced when propertyCache is full.
+bool propertyCacheEnabled = true;                                 //!< false = always sends the properties.
+
+si473x_property_cache propertyBatch[SI473X_PROPERTY_BATCH_SIZE]; //!< Properties waiting for commitProperties.
+uint8_t propertyBatchCount = 0;                                   //!< Properties stored on propertyBatch.
+uint8_t propertyBatchLevel = 0;                                   //!< Nested beginProperties calls.
+uint8_t propertyBatchDone = 0;                                    //!< Properties of the batch already completed.
+int32_t propertyBatchError = -1;                                  //!< First property of the batch that failed.
+int32_t propertyBatchFailed = -1;                                 //!< First failure of batches sent because the batch was full.
+
+static int32_t sendPropertyBatch(void);
+
+const si473x_transport *transport = SI473X_DEFAULT_TRANSPORT; //!< I2C bus, time base and GPIO used to reach the device.
+
+#ifdef SI473X_MULTI_DEVICE
+static si473x_context defaultContext = {.intPin = GPIO_SI473X_PIN_INT}; //!< Holds the globals above while another context is selected.
+static si473x_context *activeContext = &defaultContext;                //!< Context whose state is on the globals.
+
+// Initial values of the globals above (used by initContext).
+static const si473x_context contextDefaults = {
+    .deviceAddress = SI473X_ADDR_SEN_LOW,
+    .maxDelaySetFrequency = MAX_DELAY_AFTER_SET_FREQUENCY,
+    .maxDelayAfterPouwerUp = MAX_DELAY_AFTER_POWERUP,
+    .maxSeekTime = MAX_SEEK_TIME,
+    .lastMode = (uint8_t)-1,
+    .currentAvcAmMaxGain = DEFAULT_CURRENT_AVC_AM_MAX_GAIN,
+    .currentClockType = XOSCEN_CRYSTAL,
+    .refClock = 32768,
+    .refClockPrescale = 1,
+    .volume = 32,
+    .currentAudioMode = SI473X_ANALOG_AUDIO,
+    .audioMuteMcuPin = -1,
+    .ctsWaitMode = CTS_WAIT_POLLING,
+    .minDelayWaitSendLoop = MIN_DELAY_WAIT_SEND_LOOP,
+    .maxDelayCtsInterrupt = MAX_DELAY_CTS_INTERRUPT,
+    .maxDelayTuneComplete = MAX_DELAY_TUNE_COMPLETE,
+    .scanMinRssi = SCAN_MIN_RSSI,
+    .scanMinSnr = SCAN_MIN_SNR,
+    .rdsTextConfidence = RDS_TEXT_CONFIDENCE,
+    .patchDownloadMode = PATCH_DOWNLOAD_CTS,
+    .minDelayPatchPoll = MIN_DELAY_PATCH_POLL,
+    .patchResult = {PATCH_RESULT_OK, -1, 0},
+    .propertyCacheEnabled = true,
+    .propertyBatchError = -1,
+    .propertyBatchFailed = -1,
+    .transport = SI473X_DEFAULT_TRANSPORT};
+#endif
+
+static uint8_t prepareFrequencyArgs(uint16_t freq, uint8_t *args);
+static bool stcInterruptMode(void);
+static uint8_t prepareStatusCommand(uint8_t INTACK, uint8_t CANCEL, uint8_t *cmd, uint8_t *arg);
+static uint8_t prepareRsqCommand(uint8_t *cmd);
+static bool waitPatchLine(uint16_t index);
+static void startPatchResult(void);
+static char *decodeRdsTime(uint16_t blockB, uint16_t blockC, uint16_t blockD);
+static void resetRdsDecoder(void);
+static void changeRdsFrequency(uint16_t frequency);
+static void captureRdsGroup(void);
+static uint16_t decodeRdsAf(uint8_t first, uint8_t second);
+static void storeRdsStation(void);
+static uint16_t recallRdsStation(uint16_t pi);
+
 const uint16_t size_content = sizeof(ssb_patch_content); // see ssb_patch_content in patch_full.h or patch_init.h
+const uint16_t ssb_patch_crc = SSB_PATCH_CRC;
 
 //---------------------------------------------------------------------------------------------
-void SI4735_write(uint8_t *data, size_t len)
+bool SI4735_write(uint8_t *data, size_t len)
 {
-	i2cWrite(data, len, deviceAddress);
+	ctsInterruptFlag = ctsReady = 0; // A new command clears CTS; the next interrupt tells it is done.
+	return transport->write(data, len, deviceAddress);
 }
-void SI4735_write_to(uint8_t *data, size_t len, uint16_t to)
+bool SI4735_write_to(uint8_t *data, size_t len, uint16_t to)
 {
-	i2cWriteTo(data, len, deviceAddress, to);
+	ctsInterruptFlag = ctsReady = 0;
+	return transport->writeTo(data, len, deviceAddress, to);
 }
-void SI4735_read(uint8_t *data, size_t len)
+bool SI4735_read(uint8_t *data, size_t len)
 {
-	i2cRead(data, len, deviceAddress);
+	return transport->read(data, len, deviceAddress);
 }
-void SI4735_read_from(uint8_t *data, size_t len, uint16_t from)
+bool SI4735_read_from(uint8_t *data, size_t len, uint16_t from)
 {
-	i2cReadFrom(data, len, deviceAddress, from);
+	return transport->readFrom(data, len, deviceAddress, from);
 }
 void SI4735_setStep(uint16_t s)
 {
@@ -238,6 +357,7 @@ void setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t CTSIEN,
     gpio.arg.RSQREP = RSQREP;
 
     sendProperty(GPO_IEN, gpio.raw);
+    stcIntEnable = STCIEN;
 }
 
 /**
@@ -257,20 +377,16 @@ void setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t CTSIEN,
  */
 int16_t getDeviceI2CAddress()
 {
-    HAL_StatusTypeDef status;
-
     reset();
 
-    status = HAL_I2C_Master_Transmit(&hi2c1, SI473X_ADDR_SEN_LOW << 1, NULL, 0, HAL_MAX_DELAY);
-    if (status == HAL_OK)
+    if (transport->probe(SI473X_ADDR_SEN_LOW))
     {
         setDeviceI2CAddress(0);
         return SI473X_ADDR_SEN_LOW;
     }
 
     // check 0X63 I2C address
-    status = HAL_I2C_Master_Transmit(&hi2c1, SI473X_ADDR_SEN_HIGH << 1, NULL, 0, HAL_MAX_DELAY);
-    if (status == HAL_OK)
+    if (transport->probe(SI473X_ADDR_SEN_HIGH))
     {
         setDeviceI2CAddress(1);
         return SI473X_ADDR_SEN_HIGH;
@@ -328,10 +444,13 @@ void setDeviceOtherI2CAddress(uint8_t i2cAddr)
  */
 void reset()
 {
-    HAL_GPIO_WritePin(GPIO_SI473X, GPIO_SI473X_PIN, GPIO_PIN_RESET);
-    HAL_Delay(10);
-    HAL_GPIO_WritePin(GPIO_SI473X, GPIO_SI473X_PIN, GPIO_PIN_SET);
-    HAL_Delay(10);
+    ctsReady = stcIntEnable = 0;
+    residentPatch = NULL; // The patch RAM is lost
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES);
+    transport->gpioWrite(SI473X_GPIO_RESET, false);
+    transport->delayMs(10);
+    transport->gpioWrite(SI473X_GPIO_RESET, true);
+    transport->delayMs(10);
 }
 
 /**
@@ -340,19 +459,196 @@ void reset()
  * @brief  Wait for the si473x is ready (Clear to Send (CTS) status bit have to be 1).
  *
  * @details This function should be used before sending any command to a SI47XX device.
+ * @details On CTS_WAIT_INTERRUPT mode (see setCtsWaitMode) it returns as soon as the GPO2/INT interrupt
+ * signals CTS, without any I2C traffic. Otherwise, or if the interrupt does not come in maxDelayCtsInterrupt ms,
+ * it polls the status byte every minDelayWaitSendLoop microseconds.
  *
  * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 63, 128
+ * @see setCtsWaitMode, setMinDelayWaitSendLoop, SI4735_EXTI_Callback
  */
 void waitToSend()
 {
-		uint8_t temp;
-    do
+    uint8_t temp;
+
+    // Commands queued on the command engine go first.
+    flushCommandQueue();
+
+    if (ctsReady)
+        return;
+
+    if (ctsWaitMode == CTS_WAIT_INTERRUPT && powerUp.arg.CTSIEN)
+    {
+        uint32_t start = transport->millis();
+        while (!ctsInterruptFlag)
+        {
+            if ((transport->millis() - start) >= maxDelayCtsInterrupt)
+                break; // No interrupt. Falls back to polling.
+        }
+        if (ctsInterruptFlag)
+        {
+            ctsReady = 1;
+            return;
+        }
+    }
+
+    SI4735_read(&temp, 1);
+    while (!(temp & 0B10000000))
+    {
+        transport->delayUs(minDelayWaitSendLoop);
+        SI4735_read(&temp, 1);
+    }
+    ctsReady = 1;
+}
+
+/**
+ * @ingroup group06 Wait to send command
+ *
+ * @brief Handles the GPO2/INT interrupt of the SI473X.
+ *
+ * @details Call this function from the HAL_GPIO_EXTI_Callback of your application.
+ * @details It is used by waitToSend when the CTS_WAIT_INTERRUPT mode is selected.
+ * @code
+ * void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+ * {
+ *     SI4735_EXTI_Callback(GPIO_Pin);
+ * }
+ * @endcode
+ *
+ * @see setCtsWaitMode, GPIO_SI473X_PIN_INT
+ *
+ * @param GPIO_Pin the pin that triggered the EXTI interrupt
+ */
+void SI4735_EXTI_Callback(uint16_t GPIO_Pin)
+{
+#ifdef SI473X_MULTI_DEVICE
+    si473x_context *ctx;
+    uint16_t intPin = activeContext->intPin;
+#else
+    uint16_t intPin = GPIO_SI473X_PIN_INT;
+#endif
+
+    // The CTS of each command raises the line too: an edge is STC only after the CTS of the last command was seen.
+    if (GPIO_Pin == intPin)
+    {
+        if ((ctsReady || ctsInterruptFlag) && stcIntEnable)
+            stcInterruptFlag = 1;
+        ctsInterruptFlag = 1;
+        return;
+    }
+#ifdef SI473X_MULTI_DEVICE
+    // A device that is not selected: the flags wait on its context until selectContext loads it.
+    for (ctx = &defaultContext; ctx; ctx = ctx->next)
+        if (ctx != activeContext && ctx->intPin == GPIO_Pin)
+        {
+            if ((ctx->ctsReady || ctx->ctsInterruptFlag) && ctx->stcIntEnable)
+                ctx->stcInterruptFlag = 1;
+            ctx->ctsInterruptFlag = 1;
+        }
+#endif
+}
+
+/** @defgroup group22 Several devices on the same MCU */
+
+#ifdef SI473X_MULTI_DEVICE
+
+#define SI473X_SAVE_FIELD(type, name, dim) memcpy((void *)&ctx->name, (const void *)&name, sizeof(ctx->name));
+#define SI473X_LOAD_FIELD(type, name, dim) memcpy((void *)&name, (const void *)&ctx->name, sizeof(ctx->name));
+
+static void saveContext(si473x_context *ctx)
+{
+    SI473X_CONTEXT_STATE(SI473X_SAVE_FIELD)
+}
+
+static void loadContext(const si473x_context *ctx)
+{
+    SI473X_CONTEXT_STATE(SI473X_LOAD_FIELD)
+}
+
+/**
+ * @ingroup group22 Driver context
+ *
+ * @brief Prepares a context to drive another SI473X device.
+ *
+ * @details The context starts with the values the globals have at start up, bound to the transport and I2C address given.
+ * @details The globals keep being the default context: an application with a single device does not need contexts.
+ * @details Contexts are built only when SI473X_MULTI_DEVICE is defined.
+ * @details Two devices on the same I2C bus must use different addresses (SEN pin low = 0x11 and SEN pin high = 0x63).
+ * @details setup calls reset(): each device needs its own RST line, driven by the gpioWrite of its transport.
+ * @code
+ * si473x_context second;
+ * si473x_transport secondTransport; // stm32Transport with a gpioWrite that drives the RST pin of the second device
+ * initContext(&second, &secondTransport, SI473X_ADDR_SEN_HIGH, GPIO_PIN_6);
+ * setup(POWER_UP_FM); // default context: SEN low (0x11)
+ * selectContext(&second);
+ * setup(POWER_UP_FM); // second device (0x63)
+ * @endcode
+ *
+ * @see selectContext, SI4735_EXTI_Callback
+ *
+ * @param ctx     context to be initialized (must stay valid: SI4735_EXTI_Callback keeps it on a list)
+ * @param t       transport used to reach the device (NULL = SI473X_DEFAULT_TRANSPORT)
+ * @param address I2C bus address of the device
+ * @param intPin  EXTI pin of the GPO2/INT line of the device (0 = not used)
+ */
+void initContext(si473x_context *ctx, const si473x_transport *t, int16_t address, uint16_t intPin)
+{
+    si473x_context *last = &defaultContext;
+
+    while (last != ctx && last->next)
+        last = last->next;
+    if (last != ctx)
     {
-        HAL_Delay(1);
-				SI4735_read(&temp, 1);
+        ctx->next = NULL;
+        last->next = ctx;
+    }
+    memcpy((void *)ctx, (const void *)&contextDefaults, offsetof(si473x_context, next));
+    ctx->transport = (t) ? t : SI473X_DEFAULT_TRANSPORT;
+    ctx->deviceAddress = address;
+    ctx->intPin = intPin;
+    if (ctx == activeContext)
+        loadContext(ctx);
+}
+
+/**
+ * @ingroup group22 Driver context
+ *
+ * @brief Selects the device driven by the next calls of the library.
+ *
+ * @details The queued commands of the current device are completed (see flushCommandQueue). Then its state is stored
+ * @details on its context and the state of ctx is loaded on the globals. Only the globals are copied: no command is sent.
+ * @details A pending requestFrequency waits on its context until the device is selected again.
+ * @details Call it from the main loop. The INT interrupt is masked during the copy (SI473X_MASK_INT), so an edge raised
+ * @details meanwhile is handled after it, on the right context.
+ *
+ * @see initContext, getContext
+ *
+ * @param ctx context prepared by initContext (NULL = default context)
+ */
+void selectContext(si473x_context *ctx)
+{
+    if (!ctx)
+        ctx = &defaultContext;
+    if (ctx == activeContext)
+        return;
+    flushCommandQueue();
+    SI473X_MASK_INT();
+    saveContext(activeContext);
+    activeContext = ctx;
+    loadContext(ctx);
+    SI473X_UNMASK_INT();
+}
 
-    } while (!(temp & 0B10000000));
+/**
+ * @ingroup group22 Driver context
+ *
+ * @brief Returns the context of the selected device.
+ * @see selectContext
+ */
+si473x_context *getContext(void)
+{
+    return activeContext;
 }
+#endif
 
 /** @defgroup group07 Device Setup and Start up */
 
@@ -436,12 +732,16 @@ void setPowerUp(uint8_t CTSIEN, uint8_t GPO2OEN, uint8_t PATCH, uint8_t XOSCEN,
 void radioPowerUp(void)
 {
     waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES); // POWER_UP restores the default values
+    tunePending = tuneInProgress = 0;                // A coalescing tune belongs to the previous mode
+    if (powerUp.arg.FUNC != 1)
+        residentPatch = NULL; // Other firmware (FM) overwrites the SSB patch
     uint8_t dat[] = {POWER_UP, powerUp.raw[0], powerUp.raw[1]};
     SI4735_write(dat, sizeof(dat));
     // Delay at least 500 ms between powerup command and first tune command to wait for
     // the oscillator to stabilize if XOSCEN is set and crystal is used as the RCLK.
     waitToSend();
-    HAL_Delay(maxDelayAfterPouwerUp);
+    transport->delayMs(maxDelayAfterPouwerUp);
 
     // Turns the external mute circuit off
     if (audioMuteMcuPin >= 0)
@@ -486,9 +786,11 @@ void powerDown(void)
         setHardwareAudioMute(true);
 
     waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES);
+    tunePending = tuneInProgress = 0; // The device forgets the tune in progress
     uint8_t byte = POWER_DOWN;
     SI4735_write(&byte, 1);
-    HAL_Delay(3);
+    transport->delayMs(3);
 }
 
 /**
@@ -589,16 +891,16 @@ void setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel)
  *            Crystal and digital audio mode cannot be used at the same time. Populate R1 and remove C10, C11, and X1 when using digital audio.
  *
  * @param resetPin Digital Arduino Pin used to RESET de Si47XX device.
- * @param ctsIntEnable CTS Interrupt Enable.
+ * @param ctsIen CTS Interrupt Enable.
  * @param defaultFunction is the mode you want the receiver starts.
  * @param audioMode default SI473X_ANALOG_AUDIO (Analog Audio). Use SI473X_ANALOG_AUDIO or SI473X_DIGITAL_AUDIO.
  * @param clockType 0 = Use external RCLK (crystal oscillator disabled); 1 = Use crystal oscillator
- * @param gpo2Enable GPO2OE (GPO2 Output) 1 = Enable; 0 Disable (defult)
+ * @param gpo2En GPO2OE (GPO2 Output) 1 = Enable; 0 Disable (defult)
  */
-void setup_t(uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode, uint8_t clockType, uint8_t gpo2Enable)
+void setup_t(uint8_t ctsIen, uint8_t defaultFunction, uint8_t audioMode, uint8_t clockType, uint8_t gpo2En)
 {
-    ctsIntEnable = (ctsIntEnable != 0) ? 1 : 0; // Keeps old versions of the sketches running
-    gpo2Enable = gpo2Enable;
+    ctsIntEnable = (ctsIen != 0) ? 1 : 0; // Keeps old versions of the sketches running
+    gpo2Enable = gpo2En;
     currentAudioMode = audioMode;
 
     // Set the initial SI473X behavior
@@ -635,7 +937,7 @@ void setup_t(uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode, u
 void setup(uint8_t defaultFunction)
 {
     setup_t(0, defaultFunction, SI473X_ANALOG_AUDIO, XOSCEN_CRYSTAL, 0);
-    HAL_Delay(250);
+    transport->delayMs(250);
 }
 
 /** @defgroup group08 Tune, Device Mode and Filter setup */
@@ -687,12 +989,26 @@ void setTuneFrequencyAntennaCapacitor(uint16_t capacitor)
     setFrequency(currentWorkFrequency);
 }
 
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Checks if the end of a tune is signaled by the GPO2/INT interrupt (CTS_WAIT_INTERRUPT, CTSIEN and STCIEN).
+ *
+ * @details Otherwise STCINT is polled every MIN_DELAY_STC_POLL us.
+ */
+static bool stcInterruptMode(void)
+{
+    return ctsWaitMode == CTS_WAIT_INTERRUPT && powerUp.arg.CTSIEN && stcIntEnable;
+}
+
 /**
  * @ingroup   group08 Tune Frequency
  *
  * @brief Set the frequency to the corrent function of the Si4735 (FM, AM or SSB)
  *
  * @details You have to call setup or setPowerUp before call setFrequency.
+ * @details setFrequency returned void in earlier versions; it now returns whether the tune completed. Callers that
+ * @details ignore the result keep working as before.
  *
  * @see maxDelaySetFrequency()
  * @see MAX_DELAY_AFTER_SET_FREQUENCY
@@ -700,10 +1016,103 @@ void setTuneFrequencyAntennaCapacitor(uint16_t capacitor)
  * @see AN332 REV 0.8 UNIVERSAL PROGRAMMING GUIDE; page 13
  *
  * @param uint16_t  freq is the frequency to change. For example, FM => 10390 = 103.9 MHz; AM => 810 = 810 kHz.
+ * @return true if the tune completed before maxDelayTuneComplete ms (see waitTuneComplete)
+ */
+bool setFrequency(uint16_t freq)
+{
+    tunePending = tuneInProgress = 0; // This tune replaces any coalescing tune
+    sendTuneFrequency(freq);
+    return waitTuneComplete();
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Sends the tune command and returns without waiting for the end of the tune.
+ *
+ * @details Call waitTuneComplete (or poll isTuneComplete) before reading the status of the new channel.
+ *
+ * @see setFrequency, waitTuneComplete, isTuneComplete
+ *
+ * @param freq frequency to tune
+ */
+void sendTuneFrequency(uint16_t freq)
+{
+    uint8_t args[SI473X_CMD_MAX_ARGS];
+    uint8_t argc = prepareFrequencyArgs(freq, args);
+
+    stcInterruptFlag = 0;
+    runCommand(currentTune, argc, args, 0, NULL);
+    currentWorkFrequency = freq;
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Checks (GET_INT_STATUS) if the current tune or seek is complete.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 67
+ *
+ * @return true if STCINT is set
+ */
+bool isTuneComplete(void)
+{
+    si47x_status status;
+    uint8_t none = 0;
+
+    status = runCommand(GET_INT_STATUS, 0, &none, 1, &status.raw);
+    return status.refined.STCINT;
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Waits for the end of the tune (STCINT) and gets the tune status.
+ *
+ * @details Polls GET_INT_STATUS every MIN_DELAY_STC_POLL us. On interrupt mode (see setCtsWaitMode) it waits for the
+ * @details GPO2/INT interrupt instead when STCIEN was enabled with setGpioIen (polls every MAX_DELAY_CTS_INTERRUPT ms as a fallback).
+ * @details When the tune is complete, the tune status is read (see getStatus) and STCINT is cleared.
+ *
+ * @see setMaxDelayTuneComplete, sendTuneFrequency
+ *
+ * @return true if the tune completed before maxDelayTuneComplete ms
+ */
+bool waitTuneComplete(void)
+{
+    uint32_t start = transport->millis();
+    uint32_t lastPoll = start;
+    bool useInterrupt = stcInterruptMode();
+
+    for (;;)
+    {
+        if (!useInterrupt || stcInterruptFlag || (transport->millis() - lastPoll) >= maxDelayCtsInterrupt)
+        {
+            stcInterruptFlag = 0;
+            if (isTuneComplete())
+            {
+                getStatus(1, 0); // Gets the new channel status and clears STCINT
+                return true;
+            }
+            lastPoll = transport->millis();
+            if (!useInterrupt)
+                transport->delayUs(MIN_DELAY_STC_POLL);
+        }
+        if ((transport->millis() - start) >= maxDelayTuneComplete)
+            return false;
+    }
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Builds the arguments of the tune command (FM_TUNE_FREQ, AM_TUNE_FREQ or NBFM_TUNE_FREQ) for a given frequency.
+ *
+ * @param freq  frequency to tune
+ * @param args  array (SI473X_CMD_MAX_ARGS bytes) where the arguments will be stored
+ * @return uint8_t number of arguments
  */
-void setFrequency(uint16_t freq)
+static uint8_t prepareFrequencyArgs(uint16_t freq, uint8_t *args)
 {
-    waitToSend(); // Wait for the si473x is ready.
     currentFrequency.value = freq;
     currentFrequencyParams.arg.FREQH = currentFrequency.raw.FREQH;
     currentFrequencyParams.arg.FREQL = currentFrequency.raw.FREQL;
@@ -716,21 +1125,13 @@ void setFrequency(uint16_t freq)
         currentFrequencyParams.arg.FREEZE = 0;                // Used just on FM
     }
 
-    uint8_t dat[] = {
-    		currentTune,
-			currentFrequencyParams.raw[0],
-			currentFrequencyParams.arg.FREQH,
-			currentFrequencyParams.arg.FREQL,
-			currentFrequencyParams.arg.ANTCAPH,
-			currentFrequencyParams.arg.ANTCAPL
-    };
-    size_t len = sizeof(dat);
-    if (currentTune != AM_TUNE_FREQ) len--;
-    SI4735_write(dat, len);
-		
-    waitToSend();                    // Wait for the si473x is ready.
-    currentWorkFrequency = freq;     // check it
-    HAL_Delay(maxDelaySetFrequency); // For some reason I need to delay here.
+    args[0] = currentFrequencyParams.raw[0];
+    args[1] = currentFrequencyParams.arg.FREQH;
+    args[2] = currentFrequencyParams.arg.FREQL;
+    args[3] = currentFrequencyParams.arg.ANTCAPH;
+    args[4] = currentFrequencyParams.arg.ANTCAPL;
+
+    return (currentTune == AM_TUNE_FREQ) ? 5 : 4; // ANTCAPL is used just on AM
 }
 
 /**
@@ -747,7 +1148,10 @@ void frequencyUp()
     else
         currentWorkFrequency += currentStep;
 
-    setFrequency(currentWorkFrequency);
+    if (tuneCoalescing)
+        requestFrequency(currentWorkFrequency);
+    else
+        setFrequency(currentWorkFrequency);
 }
 
 /**
@@ -765,7 +1169,74 @@ void frequencyDown()
     else
         currentWorkFrequency -= currentStep;
 
-    setFrequency(currentWorkFrequency);
+    if (tuneCoalescing)
+        requestFrequency(currentWorkFrequency);
+    else
+        setFrequency(currentWorkFrequency);
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Requests a tune without waiting for it (coalescing tune).
+ *
+ * @details currentWorkFrequency is updated at once. The device is tuned by processPendingTune when it finishes the
+ * @details current tune; if several requests arrive meanwhile, just the latest one is sent.
+ * @details Useful for encoders: the display follows the knob and the bus carries only the needed tune commands.
+ *
+ * @see setTuneCoalescing, processPendingTune
+ *
+ * @param freq frequency to tune
+ */
+void requestFrequency(uint16_t freq)
+{
+    currentWorkFrequency = freq;
+    pendingTuneFrequency = freq;
+    tunePending = 1;
+    processPendingTune();
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Sends the latest requested frequency when the device is ready. It does not wait for the tune.
+ *
+ * @details Call it from the main loop while coalescing tunes are in use (see setTuneCoalescing). Without the STC
+ * @details interrupt, STCINT is read at most every MIN_DELAY_STC_POLL us. A mode switch (power up) drops the pending tune.
+ *
+ * @see requestFrequency
+ *
+ * @return true if there is still a tune in progress or pending
+ */
+bool processPendingTune(void)
+{
+    if (tuneInProgress)
+    {
+        bool useInterrupt = stcInterruptMode();
+        uint32_t now = transport->millis();
+
+        if (useInterrupt && !stcInterruptFlag && (now - tuneStartTime) < maxDelayTuneComplete)
+            return true;
+        // Polling mode: GET_INT_STATUS at most every MIN_DELAY_STC_POLL us, even if the main loop is faster
+        if (!useInterrupt && (now - lastStcPoll) * 1000UL < MIN_DELAY_STC_POLL)
+            return true;
+        lastStcPoll = now;
+        stcInterruptFlag = 0;
+        if (isTuneComplete())
+            getStatus(1, 0); // Clears STCINT
+        else if ((now - tuneStartTime) < maxDelayTuneComplete)
+            return true;
+        tuneInProgress = 0;
+    }
+    if (tunePending)
+    {
+        tunePending = 0;
+        sendTuneFrequency(pendingTuneFrequency);
+        tuneInProgress = 1;
+        tuneStartTime = lastStcPoll = transport->millis();
+        return true;
+    }
+    return false;
 }
 
 /**
@@ -788,8 +1259,10 @@ void setAM_t()
         powerDown();
         setPowerUp(ctsIntEnable, 0, 0, currentClockType, AM_CURRENT_MODE, currentAudioMode);
         radioPowerUp();
+        beginProperties();
         setAvcAmMaxGain(currentAvcAmMaxGain); // Set AM Automatic Volume Gain (default value is DEFAULT_CURRENT_AVC_AM_MAX_GAIN)
         setVolume(volume);                    // Set to previus configured volume
+        commitProperties();
     }
     currentSsbStatus = 0;
     lastMode = AM_CURRENT_MODE;
@@ -809,9 +1282,11 @@ void setFM_t()
     powerDown();
     setPowerUp(ctsIntEnable, gpo2Enable, 0, currentClockType, FM_CURRENT_MODE, currentAudioMode);
     radioPowerUp();
+    beginProperties();
     setVolume(volume); // Set to previus configured volume
-    currentSsbStatus = 0;
     disableFmDebug();
+    commitProperties();
+    currentSsbStatus = 0;
     lastMode = FM_CURRENT_MODE;
 }
 
@@ -926,12 +1401,7 @@ void setBandwidth(uint8_t AMCHFLT, uint8_t AMPLFLT)
     filter.param.AMCHFLT = AMCHFLT;
     filter.param.AMPLFLT = AMPLFLT;
 
-    waitToSend();
-		
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, filter.raw[1], filter.raw[0]};
-    SI4735_write(dat, sizeof(dat));
-		
-    waitToSend();
+    sendProperty(property.value, (filter.raw[1] << 8) | filter.raw[0]);
 }
 
 /**
@@ -966,38 +1436,50 @@ uint16_t getFrequency()
  * @param uint8_t CANCEL Cancel seek. If set, aborts a seek currently in progress;
  */
 void getStatus(uint8_t INTACK, uint8_t CANCEL)
+{
+    uint8_t cmd, arg, limitResp;
+
+    limitResp = prepareStatusCommand(INTACK, CANCEL, &cmd, &arg);
+    // Reads the current status (including current frequency).
+    runCommand(cmd, 1, &arg, limitResp, currentStatus.raw);
+    while (currentStatus.resp.ERR) // If error, try it again
+    {
+        waitToSend();
+        SI4735_read(currentStatus.raw, limitResp);
+    }
+}
+
+/**
+ * @ingroup group08 Frequency
+ *
+ * @brief Selects the tune status command (FM, AM or NBFM) and builds its argument.
+ *
+ * @param INTACK Seek/Tune Interrupt Clear
+ * @param CANCEL Cancel seek
+ * @param cmd    where the command will be stored
+ * @param arg    where the argument will be stored
+ * @return uint8_t size of the response
+ */
+static uint8_t prepareStatusCommand(uint8_t INTACK, uint8_t CANCEL, uint8_t *cmd, uint8_t *arg)
 {
     si47x_tune_status status;
-    uint8_t cmd = FM_TUNE_STATUS;
-    int limitResp = 8;
+    uint8_t limitResp = 8;
 
-    if (currentTune == FM_TUNE_FREQ)
-        cmd = FM_TUNE_STATUS;
-    else if (currentTune == AM_TUNE_FREQ)
-        cmd = AM_TUNE_STATUS;
+    *cmd = FM_TUNE_STATUS;
+    if (currentTune == AM_TUNE_FREQ)
+        *cmd = AM_TUNE_STATUS;
     else if (currentTune == NBFM_TUNE_FREQ)
     {
-        cmd = NBFM_TUNE_STATUS;
+        *cmd = NBFM_TUNE_STATUS;
         limitResp = 6;
     }
 
-    waitToSend();
-
+    status.raw = 0;
     status.arg.INTACK = INTACK;
     status.arg.CANCEL = CANCEL;
-    status.arg.RESERVED2 = 0;
-
-    uint8_t dat[] = {cmd, status.raw};
-    SI4735_write(dat, sizeof(dat));
-    // Reads the current status (including current frequency).
-    do
-    {
-    	waitToSend();
+    *arg = status.raw;
 
-    	SI4735_read(currentStatus.raw, limitResp);
-    } while (currentStatus.resp.ERR); // If error, try it again*/
-
-    waitToSend();
+    return limitResp;
 }
 
 /**
@@ -1116,44 +1598,35 @@ void setAvcAmMaxGain(uint8_t gain)
  */
 void getCurrentReceivedSignalQuality_t(uint8_t INTACK)
 {
-    uint8_t arg;
     uint8_t cmd;
-    int sizeResponse;
+    uint8_t sizeResponse = prepareRsqCommand(&cmd);
+
+    runCommand(cmd, 1, &INTACK, sizeResponse, currentRqsStatus.raw);
+}
 
+/**
+ * @ingroup group08 Received Signal Quality
+ *
+ * @brief Selects the RSQ status command of the current function (FM, AM or NBFM).
+ *
+ * @param cmd where the command will be stored
+ * @return uint8_t size of the response
+ */
+static uint8_t prepareRsqCommand(uint8_t *cmd)
+{
     if (currentTune == FM_TUNE_FREQ)
     { // FM TUNE
-        cmd = FM_RSQ_STATUS;
-        sizeResponse = 8;
+        *cmd = FM_RSQ_STATUS;
+        return 8;
     }
     else if (currentTune == NBFM_TUNE_FREQ)
     {
-        cmd = NBFM_RSQ_STATUS;
-        sizeResponse = 8; // Check it
-    }
-    else
-    { // AM TUNE
-        cmd = AM_RSQ_STATUS;
-        sizeResponse = 6; // Check it
+        *cmd = NBFM_RSQ_STATUS;
+        return 8; // Check it
     }
-
-    waitToSend();
-
-    arg = INTACK;
-		
-    uint8_t dat[] = {cmd, arg};
-    SI4735_write(dat, sizeof(dat));
-
-    // Check it
-    // do
-    //{
-    waitToSend();
-		
-		SI4735_read(currentRqsStatus.raw, sizeResponse);  
-//    SI473X_requestFrom(deviceAddress, sizeResponse);
-    // Gets response information
-//    for (uint8_t i = 0; i < sizeResponse; i++)
-//        currentRqsStatus.raw[i] = SI473X_read();
-    //} while (currentRqsStatus.resp.ERR); // Try again if error found
+    // AM TUNE
+    *cmd = AM_RSQ_STATUS;
+    return 6; // Check it
 }
 
 /**
@@ -1180,6 +1653,8 @@ void getCurrentReceivedSignalQuality(void)
  * @details __This function does not work on SSB mode__.
  * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 72, 125 and 137
  *
+ * @details The end of the seek sets STCINT. Clear it with getStatus(1, 0) when the seek is over (seekStationProgress
+ * @details and seekNextStation do it); otherwise setFrequency and waitTuneComplete take it for the end of the next tune.
  * @param SEEKUP Seek Up/Down. Determines the direction of the search, either UP = 1, or DOWN = 0.
  * @param Wrap/Halt. Determines whether the seek should Wrap = 1, or Halt = 0 when it hits the band limit.
  */
@@ -1208,7 +1683,7 @@ void seekStation(uint8_t SEEKUP, uint8_t WRAP)
     size_t len = 2;
     if (seek_start_cmd == AM_SEEK_START) len = sizeof(dat);
     SI4735_write(dat, len);
-    HAL_Delay(MAX_DELAY_AFTER_SET_FREQUENCY << 2);
+    transport->delayMs(MAX_DELAY_AFTER_SET_FREQUENCY << 2);
 }
 
 /**
@@ -1223,8 +1698,9 @@ void seekStation(uint8_t SEEKUP, uint8_t WRAP)
 void seekNextStation()
 {
     seekStation(1, 1);
-    HAL_Delay(maxDelaySetFrequency);
+    transport->delayMs(maxDelaySetFrequency);
     getFrequency();
+    getStatus(1, 0); // Clears STCINT: the next tune would see it as its own
 }
 
 /**
@@ -1238,8 +1714,31 @@ void seekNextStation()
 void seekPreviousStation()
 {
     seekStation(0, 1);
-    HAL_Delay(maxDelaySetFrequency);
+    transport->delayMs(maxDelaySetFrequency);
     getFrequency();
+    getStatus(1, 0); // Clears STCINT: the next tune would see it as its own
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Ends the seek of seekStationProgress and clears its STCINT.
+ *
+ * @details The last status read of the loop may come before the end of the seek: the seek is then cancelled where it
+ * @details is, and STCINT is cleared once set. Left set, setFrequency and waitTuneComplete would take it for the end of the next tune.
+ */
+static void endSeek(void)
+{
+    if (currentStatus.resp.STCINT)
+        return; // Already cleared by the last read (INTACK)
+    getStatus(0, 1); // CANCEL
+    if (waitTuneComplete())
+    {
+        si47x_frequency freq;
+        freq.raw.FREQH = currentStatus.resp.READFREQH;
+        freq.raw.FREQL = currentStatus.resp.READFREQL;
+        currentWorkFrequency = freq.value;
+    }
 }
 
 /**
@@ -1275,7 +1774,7 @@ void seekPreviousStation()
 void seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down)
 {
     si47x_frequency freq;
-    uint32_t elapsed_seek = _millis();
+    uint32_t elapsed_seek = transport->millis();
 
     // seek command does not work for SSB
     if (lastMode == SSB_CURRENT_MODE)
@@ -1283,15 +1782,16 @@ void seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down)
     do
     {
         seekStation(up_down, 0);
-        HAL_Delay(maxDelaySetFrequency);
-        getStatus(0, 0);
-        HAL_Delay(maxDelaySetFrequency);
+        transport->delayMs(maxDelaySetFrequency);
+        getStatus(1, 0); // Clears STCINT of a finished seek: the next tune would see it as its own
+        transport->delayMs(maxDelaySetFrequency);
         freq.raw.FREQH = currentStatus.resp.READFREQH;
         freq.raw.FREQL = currentStatus.resp.READFREQL;
         currentWorkFrequency = freq.value;
         if (showFunc != NULL)
             showFunc(freq.value);
-    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (_millis() - elapsed_seek) < maxSeekTime);
+    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (transport->millis() - elapsed_seek) < maxSeekTime);
+    endSeek();
 }
 
 /**
@@ -1330,7 +1830,7 @@ void seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down)
 void seekStationProgress_t(void (*showFunc)(uint16_t f), bool (*stopSeking)(), uint8_t up_down)
 {
     si47x_frequency freq;
-    uint32_t elapsed_seek = _millis();
+    uint32_t elapsed_seek = transport->millis();
 
     // seek command does not work for SSB
     if (lastMode == SSB_CURRENT_MODE)
@@ -1338,9 +1838,9 @@ void seekStationProgress_t(void (*showFunc)(uint16_t f), bool (*stopSeking)(), u
     do
     {
         seekStation(up_down, 0);
-        HAL_Delay(maxDelaySetFrequency);
-        getStatus(0, 0);
-        HAL_Delay(maxDelaySetFrequency);
+        transport->delayMs(maxDelaySetFrequency);
+        getStatus(1, 0); // Clears STCINT of a finished seek: the next tune would see it as its own
+        transport->delayMs(maxDelaySetFrequency);
         freq.raw.FREQH = currentStatus.resp.READFREQH;
         freq.raw.FREQL = currentStatus.resp.READFREQL;
         currentWorkFrequency = freq.value;
@@ -1348,56 +1848,480 @@ void seekStationProgress_t(void (*showFunc)(uint16_t f), bool (*stopSeking)(), u
             showFunc(freq.value);
         if (stopSeking != NULL)
             if (stopSeking())
+            {
+                endSeek();
                 return;
+            }
 
-    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (_millis() - elapsed_seek) < maxSeekTime);
+    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (transport->millis() - elapsed_seek) < maxSeekTime);
+    endSeek();
 }
 
 /**
- * @ingroup group08 Seek
- *
- * @brief Sets the bottom frequency and top frequency of the AM band for seek. Default is 520 to 1710.
+ * @ingroup group08 Band Scan
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 127, 161, and 162
- *
- * @param uint16_t bottom - the bottom of the AM (MW/SW) mode for seek
- * @param uint16_t    top - the top of the AM (MW/SW) mode for seek
+ * @brief Rank of a scanned channel: the higher the better.
  */
-void setSeekAmLimits(uint16_t bottom, uint16_t top)
+static uint16_t scanScore(const si473x_scan_entry *entry)
 {
-    sendProperty(AM_SEEK_BAND_BOTTOM, bottom);
-    sendProperty(AM_SEEK_BAND_TOP, top);
+    return (uint16_t)entry->rssi + entry->snr;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group08 Band Scan
  *
- * @brief Sets the bottom frequency and top frequency of the FM band for seek. Default is 8750 to 10790.
- *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 100 and  101
- *
- * @param uint16_t bottom - the bottom of the FM(VHF) mode for seek
- * @param uint16_t    top - the top of the FM(VHF) mode for seek
- */
-void setSeekFmLimits(uint16_t bottom, uint16_t top)
-{
-    sendProperty(FM_SEEK_BAND_BOTTOM, bottom);
-    sendProperty(FM_SEEK_BAND_TOP, top);
-}
-
-/**
- * @ingroup group08 Seek
+ * @brief Scans the whole band and builds a table of the stations found, the strongest first.
  *
- * @brief Selects frequency spacingfor AM seek. Default is 10 kHz spacing.
+ * @details Tunes (FAST mode) every channel from currentMinimumFrequency to currentMaximumFrequency (currentStep spacing),
+ * @details waits for STC, waits dwellMs and reads the RSQ status (RSSI, SNR, multipath and frequency offset).
+ * @details Channels below the scan thresholds (see setScanThreshold) are discarded. On FM, when two adjacent channels pass,
+ * @details just the stronger one is kept (the other is usually the same station). On AM, stations 9 or 10 kHz apart are
+ * @details real, so every channel that passes is kept. If the table is full, the weakest entry gives place to a stronger channel.
+ * @details At the end, the table is sorted by RSSI + SNR (descending) and the receiver goes back to the frequency it had
+ * @details before the scan.
+ * @details __This function does not work on SSB mode__.
+ * @code
+ * si473x_scan_entry stations[20];
+ * uint16_t n = scanBand(stations, 20, 10, NULL);
+ * for (uint16_t i = 0; i < n; i++)
+ *     printf("%u %u dBuV %u dB\n", stations[i].frequency, stations[i].rssi, stations[i].snr);
+ * @endcode
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 163, 229 and 283
+ * @see setScanThreshold, getCurrentReceivedSignalQuality
  *
- * @param uint16_t spacing - step in kHz
+ * @param stations    table where the stations are stored (preallocated by the caller)
+ * @param maxStations number of entries of the table
+ * @param dwellMs     time (ms) the receiver stays on each channel before the RSQ status is read (0 = none)
+ * @param showFunc    function called with each channel scanned (set NULL if you do not want to show the progress)
+ * @return uint16_t   number of stations stored in the table
  */
-void setSeekAmSpacing(uint16_t spacing)
+uint16_t scanBand(si473x_scan_entry *stations, uint16_t maxStations, uint16_t dwellMs, void (*showFunc)(uint16_t f))
 {
-    sendProperty(AM_SEEK_FREQ_SPACING, spacing);
-}
+    uint16_t count = 0;
+    int16_t last = -1; // Entry of the previous channel (-1 = it did not pass)
+    uint16_t saved = currentWorkFrequency;
+    uint8_t savedFast = currentFrequencyParams.arg.FAST;
+    uint32_t freq;
+
+    if (lastMode == SSB_CURRENT_MODE || stations == NULL || maxStations == 0 || currentStep == 0)
+        return 0;
+
+    currentFrequencyParams.arg.FAST = 1;
+    for (freq = currentMinimumFrequency; freq <= currentMaximumFrequency; freq += currentStep)
+    {
+        si473x_scan_entry entry;
+        int16_t slot = -1;
+
+        sendTuneFrequency((uint16_t)freq);
+        waitTuneComplete();
+        if (dwellMs)
+            transport->delayMs(dwellMs);
+        getCurrentReceivedSignalQuality_t(0);
+        if (showFunc != NULL)
+            showFunc((uint16_t)freq);
+
+        entry.frequency = (uint16_t)freq;
+        entry.rssi = currentRqsStatus.resp.RSSI;
+        entry.snr = currentRqsStatus.resp.SNR;
+        if (currentTune == FM_TUNE_FREQ)
+        {
+            entry.multipath = currentRqsStatus.resp.MULT;
+            entry.frequencyOffset = (int8_t)currentRqsStatus.resp.FREQOFF;
+        }
+        else // The AM RSQ response has no MULT and FREQOFF bytes (currentRqsStatus keeps the ones of the last FM read)
+            entry.multipath = entry.frequencyOffset = 0;
+
+        if (entry.rssi < scanMinRssi || entry.snr < scanMinSnr)
+        {
+            last = -1;
+            continue;
+        }
+        if (last >= 0 && currentTune == FM_TUNE_FREQ)
+        { // Adjacent FM channel: keeps the stronger one
+            if (scanScore(&entry) > scanScore(&stations[last]))
+                stations[last] = entry;
+            continue;
+        }
+        if (count < maxStations)
+            slot = count++;
+        else
+        { // Table full: replaces the weakest entry
+            uint16_t i, weakest = 0;
+            for (i = 1; i < count; i++)
+                if (scanScore(&stations[i]) < scanScore(&stations[weakest]))
+                    weakest = i;
+            if (scanScore(&entry) > scanScore(&stations[weakest]))
+                slot = weakest;
+        }
+        if (slot >= 0)
+            stations[slot] = entry;
+        last = slot;
+    }
+    currentFrequencyParams.arg.FAST = savedFast;
+
+    // Insertion sort: the strongest first; same rank, the lowest frequency first
+    for (uint16_t i = 1; i < count; i++)
+    {
+        si473x_scan_entry key = stations[i];
+        int16_t j = i - 1;
+        while (j >= 0 && (scanScore(&stations[j]) < scanScore(&key) ||
+                          (scanScore(&stations[j]) == scanScore(&key) && stations[j].frequency > key.frequency)))
+        {
+            stations[j + 1] = stations[j];
+            j--;
+        }
+        stations[j + 1] = key;
+    }
+
+    setFrequency(saved);
+    return count;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Rank of a station record: the higher the better.
+ */
+static uint16_t stationScore(const si473x_station_record *record)
+{
+    return (uint16_t)record->rssi + record->snr;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Returns the rank (position on db->order) of the station on freq or db->count if there is none.
+ */
+static uint8_t findStationRank(const si473x_station_db *db, uint16_t freq)
+{
+    uint8_t rank;
+
+    for (rank = 0; rank < db->count; rank++)
+        if (db->records[db->order[rank]].frequency == freq)
+            break;
+    return rank;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Moves the record on rank up or down db->order until the order is right again.
+ */
+static void sortStationRank(si473x_station_db *db, uint8_t rank)
+{
+    uint8_t index = db->order[rank];
+    uint16_t score = stationScore(&db->records[index]);
+
+    while (rank > 0 && stationScore(&db->records[db->order[rank - 1]]) < score)
+    {
+        db->order[rank] = db->order[rank - 1];
+        rank--;
+    }
+    while (rank + 1 < db->count && stationScore(&db->records[db->order[rank + 1]]) > score)
+    {
+        db->order[rank] = db->order[rank + 1];
+        rank++;
+    }
+    db->order[rank] = index;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Removes the station on freq (if any). The last record takes the place of the removed one.
+ */
+static void removeStation(si473x_station_db *db, uint16_t freq)
+{
+    uint8_t rank = findStationRank(db, freq);
+    uint8_t index, last = db->count - 1;
+
+    if (rank == db->count)
+        return;
+    index = db->order[rank];
+    for (; rank < last; rank++)
+        db->order[rank] = db->order[rank + 1];
+    if (index != last)
+    {
+        db->records[index] = db->records[last];
+        for (rank = 0; db->order[rank] != last; rank++)
+            ;
+        db->order[rank] = index;
+    }
+    db->count = last;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Stores the signal of a station on the database.
+ *
+ * @details A new station takes a free record or the record of the weakest station (if it is weaker).
+ *
+ * @return the record index or -1 if the station was not stored
+ */
+static int16_t storeStation(si473x_station_db *db, uint16_t freq, uint8_t rssi, uint8_t snr)
+{
+    uint8_t rank = findStationRank(db, freq);
+    si473x_station_record *record;
+
+    if (rank == db->count)
+    {
+        if (db->count < SI473X_STATION_DB_SIZE)
+            db->order[db->count++] = rank;
+        else if ((uint16_t)rssi + snr <= stationScore(&db->records[db->order[--rank]]))
+            return -1;
+        record = &db->records[db->order[rank]];
+        record->frequency = freq;
+        record->pi = 0;
+        record->ps[0] = '\0';
+    }
+    record = &db->records[db->order[rank]];
+    record->rssi = rssi;
+    record->snr = snr;
+    record->lastSeen = transport->millis();
+    sortStationRank(db, rank);
+    return (int16_t)(record - db->records);
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Reads the RSQ status of the channel visited and updates the database.
+ *
+ * @details Like scanBand, on FM a channel adjacent to a stronger one is taken as the same station.
+ *
+ * @return true if the station was stored and its RDS can be listened to
+ */
+static bool checkBackgroundChannel(si473x_station_db *db)
+{
+    uint8_t rssi, snr;
+    uint16_t score;
+    int16_t index;
+    bool adjacent; // The previous channel passed too: on FM, both are the same station
+
+    getCurrentReceivedSignalQuality_t(0);
+    rssi = currentRqsStatus.resp.RSSI;
+    snr = currentRqsStatus.resp.SNR;
+    score = (uint16_t)rssi + snr;
+    adjacent = db->lastScore && currentTune == FM_TUNE_FREQ;
+
+    if (rssi < scanMinRssi || snr < scanMinSnr || (adjacent && db->lastScore >= score))
+    {
+        uint8_t rank = findStationRank(db, db->frequency);
+        if (rank < db->count && (rssi < scanMinRssi || snr < scanMinSnr))
+        { // Known station that faded: keeps the record with the signal seen now (it goes down on the rank)
+            db->records[db->order[rank]].rssi = rssi;
+            db->records[db->order[rank]].snr = snr;
+            sortStationRank(db, rank);
+        }
+        else if (rank < db->count)
+            removeStation(db, db->frequency);
+        if (rssi < scanMinRssi || snr < scanMinSnr)
+            db->lastScore = 0;
+        return false;
+    }
+    if (adjacent)
+        removeStation(db, db->frequency - db->step); // The previous channel was the weaker side of this station
+    db->lastScore = score;
+    index = storeStation(db, db->frequency, rssi, snr);
+    if (index < 0)
+        return false;
+    db->visiting = (uint8_t)index;
+    return true;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Starts the background scan: a station database refreshed channel by channel without blocking.
+ *
+ * @details The band is the one of the receiver (currentMinimumFrequency to currentMaximumFrequency, currentStep spacing).
+ * @details Each call of processBackgroundScan does one step: tune (FAST mode), check STC, read the RSQ status or
+ * @details read the RDS (PI and PS; see processRdsGroup) for rdsWindowMs. Without the STC interrupt, STCINT is read
+ * @details at most every MIN_DELAY_STC_POLL us, however fast the main loop is. Stations under the scan thresholds
+ * @details (see setScanThreshold) are not stored; a station already stored keeps its record with the new signal.
+ * @details Use a second device (see selectContext) or mute the receiver: it leaves the frequency being listened to.
+ * @details The RDS must be enabled (setRdsConfig) to get PI and PS. The database is kept when the scan is restarted.
+ * @code
+ * si473x_station_db db;
+ * memset(&db, 0, sizeof(db));
+ * selectContext(&second);
+ * startBackgroundScan(&db, SCAN_RDS_WINDOW);
+ * selectContext(NULL);
+ * for (;;)
+ * {
+ *     selectContext(&second);
+ *     processBackgroundScan(&db);
+ *     selectContext(NULL);
+ *     best = getBestStation(&db, 0); // Best station now
+ * }
+ * @endcode
+ *
+ * @see processBackgroundScan, stopBackgroundScan, getBestStation, scanBand
+ *
+ * @param db          database (set all bytes to 0 before the first use)
+ * @param rdsWindowMs time (ms) the RDS of each station is listened to (0 = RSQ only; SCAN_RDS_WINDOW is enough for PI and PS)
+ */
+void startBackgroundScan(si473x_station_db *db, uint16_t rdsWindowMs)
+{
+    if (lastMode == SSB_CURRENT_MODE || currentStep == 0)
+        return;
+    db->minimumFrequency = currentMinimumFrequency;
+    db->maximumFrequency = currentMaximumFrequency;
+    db->step = currentStep;
+    db->frequency = currentMinimumFrequency;
+    db->rdsWindowMs = (currentTune == FM_TUNE_FREQ) ? rdsWindowMs : 0;
+    db->lastScore = 0;
+    db->savedFrequency = currentWorkFrequency;
+    db->savedFast = currentFrequencyParams.arg.FAST;
+    db->state = SI473X_BGSCAN_TUNE;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Does the next step of the background scan. Call it from the main loop.
+ *
+ * @details Select the device used by startBackgroundScan before calling it.
+ *
+ * @see startBackgroundScan
+ *
+ * @param db database given to startBackgroundScan
+ * @return false if the background scan is not running
+ */
+bool processBackgroundScan(si473x_station_db *db)
+{
+    uint32_t now = transport->millis();
+
+    switch (db->state)
+    {
+    case SI473X_BGSCAN_TUNE:
+        currentFrequencyParams.arg.FAST = 1;
+        sendTuneFrequency(db->frequency);
+        db->stateStart = db->lastStcPoll = now;
+        db->state = SI473X_BGSCAN_WAIT_STC;
+        return true;
+    case SI473X_BGSCAN_WAIT_STC:
+        if (stcInterruptMode())
+        {
+            if (!stcInterruptFlag && (now - db->stateStart) < maxDelayTuneComplete)
+                return true;
+        }
+        else if ((now - db->lastStcPoll) * 1000UL < MIN_DELAY_STC_POLL)
+            return true; // Polling mode: GET_INT_STATUS at most every MIN_DELAY_STC_POLL us, like processPendingTune
+        db->lastStcPoll = now;
+        stcInterruptFlag = 0;
+        if (isTuneComplete())
+        {
+            getStatus(1, 0); // Clears STCINT
+            if (checkBackgroundChannel(db) && db->rdsWindowMs)
+            {
+                db->stateStart = now;
+                db->state = SI473X_BGSCAN_RDS;
+                return true;
+            }
+        }
+        else if ((now - db->stateStart) < maxDelayTuneComplete)
+            return true;
+        break;
+    case SI473X_BGSCAN_RDS:
+    {
+        si473x_station_record *record = &db->records[db->visiting];
+
+        // The groups go through processRdsGroup (the decoder was reset by the new frequency): voted PS, confirmed PI
+        drainRdsFifo(NULL);
+        if (rdsInfo.pi != 0)
+            record->pi = rdsInfo.pi;
+        if (isRdsStationNameComplete())
+            strcpy(record->ps, rds_buffer0A);
+        if ((!isRdsStationNameComplete() || record->pi == 0) && (now - db->stateStart) < db->rdsWindowMs)
+            return true;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    // Next channel
+    if ((uint32_t)db->frequency + db->step > db->maximumFrequency)
+    {
+        db->frequency = db->minimumFrequency;
+        db->lastScore = 0;
+        db->cycles++;
+    }
+    else
+        db->frequency += db->step;
+    db->state = SI473X_BGSCAN_TUNE;
+    return true;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ *
+ * @brief Stops the background scan and tunes the frequency the receiver had before startBackgroundScan.
+ *
+ * @details The database is kept (getBestStation keeps working).
+ *
+ * @param db database given to startBackgroundScan
+ */
+void stopBackgroundScan(si473x_station_db *db)
+{
+    if (db->state == SI473X_BGSCAN_IDLE)
+        return;
+    db->state = SI473X_BGSCAN_IDLE;
+    currentFrequencyParams.arg.FAST = db->savedFast;
+    setFrequency(db->savedFrequency);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the bottom frequency and top frequency of the AM band for seek. Default is 520 to 1710.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 127, 161, and 162
+ *
+ * @param uint16_t bottom - the bottom of the AM (MW/SW) mode for seek
+ * @param uint16_t    top - the top of the AM (MW/SW) mode for seek
+ */
+void setSeekAmLimits(uint16_t bottom, uint16_t top)
+{
+    beginProperties();
+    sendProperty(AM_SEEK_BAND_BOTTOM, bottom);
+    sendProperty(AM_SEEK_BAND_TOP, top);
+    commitProperties();
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the bottom frequency and top frequency of the FM band for seek. Default is 8750 to 10790.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 100 and  101
+ *
+ * @param uint16_t bottom - the bottom of the FM(VHF) mode for seek
+ * @param uint16_t    top - the top of the FM(VHF) mode for seek
+ */
+void setSeekFmLimits(uint16_t bottom, uint16_t top)
+{
+    beginProperties();
+    sendProperty(FM_SEEK_BAND_BOTTOM, bottom);
+    sendProperty(FM_SEEK_BAND_TOP, top);
+    commitProperties();
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Selects frequency spacingfor AM seek. Default is 10 kHz spacing.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 163, 229 and 283
+ *
+ * @param uint16_t spacing - step in kHz
+ */
+void setSeekAmSpacing(uint16_t spacing)
+{
+    sendProperty(AM_SEEK_FREQ_SPACING, spacing);
+}
 
 /**
  * @ingroup group08 Seek
@@ -1408,633 +2332,2161 @@ void setSeekAmSpacing(uint16_t spacing)
  *
  * @param uint16_t spacing - step in kHz
  */
-void setSeekFmSpacing(uint16_t spacing)
+void setSeekFmSpacing(uint16_t spacing)
+{
+    sendProperty(FM_SEEK_FREQ_SPACING, spacing);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the RSSI threshold for a valid AM Seek/Tune.
+ *
+ * @details If the value is zero then RSSI threshold is not considered when doing a seek. Default value is 25 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 127
+ */
+void setSeekAmRssiThreshold(uint16_t value)
+{
+    sendProperty(AM_SEEK_RSSI_THRESHOLD, value);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the RSSI threshold for a valid FM Seek/Tune.
+ *
+ * @details RSSI threshold which determines if a valid channel has been found during seek/tune. Specified in units of dBμV in 1 dBμV steps (0–127). Default is 20 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 102
+ */
+void setSeekFmRssiThreshold(uint16_t value)
+{
+    sendProperty(FM_SEEK_TUNE_RSSI_THRESHOLD, value);
+}
+
+/** @defgroup group10 Generic SI473X Command and Property methods
+ * @details A set of functions used to support other functions
+ */
+
+/**
+ * @ingroup group10 Generic send property
+ *
+ * @brief Sends (sets) property to the SI47XX
+ *
+ * @details This method is used for others to send generic properties and params to SI47XX
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 68, 124 and  133.
+ * @see setProperty, sendCommand, getProperty, getCommandResponse
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @param parameter   property value that will be seted
+ */
+void sendProperty(uint16_t propertyNumber, uint16_t parameter)
+{
+    si47x_property property;
+    si47x_property param;
+
+    int32_t cached;
+
+    if (propertyBatchLevel > 0)
+    {
+        addProperty(propertyNumber, parameter); // Sent by commitProperties
+        return;
+    }
+
+    cached = getCachedProperty(propertyNumber);
+    if (cached == parameter && isCommandQueueEmpty())
+        return; // The device already has this value
+
+    property.value = propertyNumber;
+    param.value = parameter;
+    uint8_t args[] = {0, property.raw.byteHigh, property.raw.byteLow, param.raw.byteHigh, param.raw.byteLow};
+    runCommand(SET_PROPERTY, sizeof(args), args, 0, NULL);
+}
+
+/**
+ * @ingroup group10 Property cache
+ *
+ * @brief Gets the last value written to a property (shadow table).
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @return int32_t the value or -1 if the value is not known
+ */
+int32_t getCachedProperty(uint16_t propertyNumber)
+{
+    for (uint8_t i = 0; i < propertyCacheCount; i++)
+        if (propertyCache[i].used && propertyCache[i].property == propertyNumber)
+            return propertyCache[i].value;
+    return -1;
+}
+
+/**
+ * @ingroup group10 Property cache
+ *
+ * @brief Stores the value of a property in the shadow table.
+ * @details A new property takes the first slot freed by invalidateCachedProperty. When the table is full,
+ * @details the oldest entry is replaced.
+ *
+ * @param propertyNumber property number
+ * @param value          value written to the device
+ */
+void setCachedProperty(uint16_t propertyNumber, uint16_t value)
+{
+    uint8_t i;
+    uint8_t freeSlot = SI473X_PROPERTY_CACHE_SIZE;
+
+    if (!propertyCacheEnabled)
+        return;
+    for (i = 0; i < propertyCacheCount; i++)
+    {
+        if (propertyCache[i].used && propertyCache[i].property == propertyNumber)
+            break;
+        if (!propertyCache[i].used && freeSlot == SI473X_PROPERTY_CACHE_SIZE)
+            freeSlot = i;
+    }
+    if (i == propertyCacheCount)
+    {
+        if (freeSlot < SI473X_PROPERTY_CACHE_SIZE)
+            i = freeSlot;
+        else if (propertyCacheCount < SI473X_PROPERTY_CACHE_SIZE)
+            propertyCacheCount++;
+        else
+        {
+            i = propertyCacheNext;
+            propertyCacheNext = (propertyCacheNext + 1) % SI473X_PROPERTY_CACHE_SIZE;
+        }
+    }
+    propertyCache[i].property = propertyNumber;
+    propertyCache[i].value = value;
+    propertyCache[i].used = true;
+}
+
+/**
+ * @ingroup group10 Property cache
+ *
+ * @brief Forgets the value of a property (or of all properties).
+ * @details The device goes back to the default values after POWER_UP, so the table is cleared by
+ * @details powerDown, reset and the power up / patch functions. Call it if you change properties with sendCommand.
+ *
+ * @param propertyNumber property number or SI473X_ALL_PROPERTIES
+ */
+void invalidateCachedProperty(uint16_t propertyNumber)
+{
+    if (propertyNumber == SI473X_ALL_PROPERTIES)
+    {
+        propertyCacheCount = propertyCacheNext = 0;
+        return;
+    }
+    for (uint8_t i = 0; i < propertyCacheCount; i++)
+        if (propertyCache[i].property == propertyNumber)
+            propertyCache[i].used = false; // Free slot; reused by the next new property
+}
+
+/**
+ * @ingroup group10 Property batch
+ *
+ * @brief Starts a property batch.
+ * @details Until commitProperties is called, sendProperty (and the functions that use it, like setVolume or setSeekFmLimits)
+ * @details just store the property in the batch. Batches can be nested; the outermost commitProperties sends them.
+ * @details Meanwhile getProperty answers with the value stored in the batch.
+ *
+ * @code
+ * beginProperties();
+ * setVolume(45);
+ * setSeekFmLimits(8750, 10800);
+ * addProperty(FM_DEEMPHASIS, 1);
+ * if (commitProperties() >= 0)
+ *    // some property failed
+ * @endcode
+ *
+ * @see addProperty, commitProperties
+ */
+void beginProperties(void)
+{
+    if (propertyBatchLevel++ == 0)
+        propertyBatchCount = 0;
+}
+
+/**
+ * @ingroup group10 Property batch
+ *
+ * @brief Adds a property to the current batch.
+ * @details A property already in the batch gets the new value. A value the device already has (see getCachedProperty) is not added.
+ * @details If the batch is full, the stored properties are sent first.
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @param value          property value
+ */
+void addProperty(uint16_t propertyNumber, uint16_t value)
+{
+    uint8_t i;
+
+    for (i = 0; i < propertyBatchCount; i++)
+        if (propertyBatch[i].property == propertyNumber)
+        {
+            propertyBatch[i].value = value;
+            return;
+        }
+    if (getCachedProperty(propertyNumber) == value)
+        return;
+    if (propertyBatchCount == SI473X_PROPERTY_BATCH_SIZE)
+    {
+        int32_t failed = sendPropertyBatch();
+        if (propertyBatchFailed < 0)
+            propertyBatchFailed = failed;
+    }
+    propertyBatch[propertyBatchCount].property = propertyNumber;
+    propertyBatch[propertyBatchCount].value = value;
+    propertyBatch[propertyBatchCount].used = true;
+    propertyBatchCount++;
+}
+
+/**
+ * @ingroup group10 Property batch
+ *
+ * @brief Counts the completed SET_PROPERTY commands of the batch and keeps the first one that failed.
+ */
+static void propertyBatchCallback(uint8_t cmd, si47x_status status, uint8_t *response)
+{
+    (void)cmd;      // Always SET_PROPERTY
+    (void)response; // SET_PROPERTY has no response
+    if (status.refined.ERR && propertyBatchError < 0)
+        propertyBatchError = propertyBatch[propertyBatchDone].property;
+    propertyBatchDone++;
+}
+
+/**
+ * @ingroup group10 Property batch
+ *
+ * @brief Sends the stored properties back-to-back through the command engine.
+ * @details The engine sends the next property as soon as CTS is seen; the CPU sleeps (minDelayWaitSendLoop)
+ * @details only while the device is busy.
+ *
+ * @return int32_t the first property that failed or -1 if all of them were accepted
+ */
+static int32_t sendPropertyBatch(void)
+{
+    si47x_property property, param;
+    uint8_t queued = 0;
+    uint8_t head, state;
+
+    propertyBatchDone = 0;
+    propertyBatchError = -1;
+    while (propertyBatchDone < propertyBatchCount)
+    {
+        // Keeps the queue full
+        while (queued < propertyBatchCount)
+        {
+            property.value = propertyBatch[queued].property;
+            param.value = propertyBatch[queued].value;
+            uint8_t args[] = {0, property.raw.byteHigh, property.raw.byteLow, param.raw.byteHigh, param.raw.byteLow};
+            if (queueCommand(SET_PROPERTY, sizeof(args), args, 0, NULL, propertyBatchCallback) == 0)
+                break;
+            queued++;
+        }
+        head = commandQueueHead;
+        state = commandEngineState;
+        processCommandQueue();
+        if (head == commandQueueHead && state == commandEngineState)
+            transport->delayUs(minDelayWaitSendLoop); // The device is busy
+    }
+    propertyBatchCount = 0;
+    return propertyBatchError;
+}
+
+/**
+ * @ingroup group10 Property batch
+ *
+ * @brief Sends the properties of the batch started by beginProperties.
+ *
+ * @return int32_t the first property that failed or -1 if all of them were accepted (or the batch is nested)
+ */
+int32_t commitProperties(void)
+{
+    int32_t failed;
+
+    if (propertyBatchLevel == 0 || --propertyBatchLevel > 0)
+        return -1;
+    // Commands queued before the batch go first; their callbacks do not belong to the batch.
+    flushCommandQueue();
+    failed = sendPropertyBatch();
+    if (propertyBatchFailed >= 0)
+        failed = propertyBatchFailed;
+    propertyBatchFailed = -1;
+    return failed;
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief Sends a given command to the SI47XX devices.
+ * @details This function can be useful when you want to execute a SI47XX device command and it was not implemented by this library.
+ * @details In this case you have to check the  AN332-Si47XX PROGRAMMING GUIDE to know how the command works.
+ * @details Also, you need to work with bit operators to compose the parameters of the command [ &(and), ˆ(xor), |(or) etc ].
+ *
+ * @see getCommandResponse, setProperty
+ *
+ * @param cmd command number (see AN332-Si47XX PROGRAMMING GUIDE)
+ * @param parameter_size Parameter size in bytes. Tell the number of argument used by the command.
+ * @param parameter unsigned byte array with the arguments of the command
+ */
+void sendCommand(uint8_t cmd, int parameter_size, const uint8_t *parameter)
+{
+    waitToSend();
+    if (cmd == SET_PROPERTY || cmd == POWER_UP || cmd == POWER_DOWN)
+        invalidateCachedProperty(SI473X_ALL_PROPERTIES);
+    uint8_t *dat = (uint8_t *)calloc(1, parameter_size + 1);
+    if (dat) {
+    	*dat = cmd;
+    	memcpy(dat + 1, parameter, parameter_size);
+        SI4735_write(dat, parameter_size + 1);
+        free(dat);
+    }
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief   Returns with the command response.
+ * @details After a command is executed by the device, you can get the result (response) of the command by calling this method.
+ *
+ * @see sendCommand, setProperty
+ *
+ * @param response_size  num of bytes returned by the command.
+ * @param response  byte array where the response will be stored.
+ */
+void getCommandResponse(int response_size, uint8_t *response)
+{
+    waitToSend();
+	SI4735_read(response, response_size);
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief Gets the first byte response.
+ * @details In this context status is the first response byte for any SI47XX command. See si47x_status structure.
+ * @details This function can be useful to check, for example, the success or failure of a command.
+ *
+ * @see si47x_status
+ *
+ * @return si47x_status
+ */
+si47x_status getStatusResponse()
+{
+    si47x_status status;
+
+    SI4735_read(&status.raw, 1);
+
+    return status;
+}
+
+/**
+ * @ingroup group10 Generic get property
+ *
+ * @brief Gets a given property from the SI47XX
+ *
+ * @details This method is used to get a given property from SI47XX
+ * @details You might need to extract set of bits information from the returned value to know the real value
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 69, 124 and  134.
+ * @see sendProperty, setProperty, sendCommand, getCommandResponse
+ *
+ * @details Inside a property batch (see beginProperties), a property of the batch gives the value that commitProperties will send.
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ *
+ * @return property value  (the content of the property)
+ */
+int32_t
+getProperty(uint16_t propertyNumber)
+{
+    si47x_property property;
+    si47x_status status;
+    int32_t cached;
+
+    for (uint8_t i = 0; i < propertyBatchCount; i++)
+        if (propertyBatch[i].property == propertyNumber)
+            return propertyBatch[i].value; // Not sent yet: the device still has the old value
+
+    cached = getCachedProperty(propertyNumber);
+    if (cached >= 0)
+        return cached;
+
+    property.value = propertyNumber;
+    uint8_t dat[] = {0, property.raw.byteHigh, property.raw.byteLow, 0};
+    status = runCommand(GET_PROPERTY, 3, dat, 4, dat);
+
+    // if error, return 0;
+    if (status.refined.ERR == 1)
+        return -1;
+
+    //SI473X_read(); // dummy
+
+    // gets the property value
+    property.raw.byteHigh = dat[2];//Wire.read();
+    property.raw.byteLow = dat[3];//Wire.read();
+
+    setCachedProperty(propertyNumber, property.value);
+    return property.value;
+}
+
+/** @defgroup group21 Non-blocking command engine
+ * @details Commands are stored on a small queue and sent to the device by processCommandQueue().
+ * @details Call processCommandQueue() from the main loop (or from a timer) and poll isCommandDone()
+ * @details or register a callback to know when the response is available.
+ * @details The legacy blocking functions (sendProperty, setFrequency, getStatus etc.) run on top of this engine.
+ */
+
+#define COMMAND_ENGINE_IDLE 0     //!< No command in progress
+#define COMMAND_ENGINE_WAIT_CTS 1 //!< Waiting for CTS to send the command
+#define COMMAND_ENGINE_SENT 2     //!< Command sent; waiting for CTS to read the response
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Checks, without blocking, if the device is ready to receive a new command or to return a response.
+ *
+ * @details On interrupt mode no I2C transaction is made until the CTS interrupt arrives or maxDelayCtsInterrupt expires.
+ *
+ * @param status where the status byte will be stored
+ * @return true if CTS is set
+ */
+static bool isClearToSend(uint8_t *status)
+{
+    if (ctsReady || ctsInterruptFlag)
+    {
+        *status = 0B10000000;
+        return (ctsReady = 1);
+    }
+
+    if (ctsWaitMode == CTS_WAIT_INTERRUPT && powerUp.arg.CTSIEN && (transport->millis() - commandStartTime) < maxDelayCtsInterrupt)
+        return false;
+
+    SI4735_read(status, 1);
+    ctsReady = (*status & 0B10000000) != 0;
+    return ctsReady;
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Removes the current command from the queue and calls its callback.
+ *
+ * @param status status of the command
+ */
+static void completeCommand(si47x_status status)
+{
+    si473x_command *c = &commandQueue[commandQueueHead];
+    void (*callback)(uint8_t, si47x_status, uint8_t *) = c->callback;
+    uint8_t cmd = c->cmd;
+    uint8_t *response = c->response;
+
+    lastCommandStatus = status;
+    if (cmd == SET_PROPERTY)
+    {
+        uint16_t property = (c->args[1] << 8) | c->args[2];
+        if (status.refined.ERR)
+            invalidateCachedProperty(property);
+        else
+            setCachedProperty(property, (c->args[3] << 8) | c->args[4]);
+    }
+    commandQueueHead = (commandQueueHead + 1) % SI473X_CMD_QUEUE_SIZE;
+    if (++commandDoneTicket == 0)
+        commandDoneTicket = 1;
+    commandEngineState = COMMAND_ENGINE_IDLE;
+    commandEngineBusy = 0;
+
+    if (callback)
+        callback(cmd, status, response);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues a command to the device.
+ *
+ * @details The command is sent by processCommandQueue(). The response (including the status byte)
+ * @details is stored in response and the callback (if not NULL) is called when the command is completed.
+ * @details The args and the command are copied. The response array must be valid until the command is completed.
+ *
+ * @param cmd          command number (see AN332-Si47XX PROGRAMMING GUIDE)
+ * @param argc         number of arguments (up to SI473X_CMD_MAX_ARGS)
+ * @param args         arguments of the command
+ * @param responseSize number of bytes of the response (0 if the response is not needed)
+ * @param response     byte array where the response will be stored
+ * @param callback     function called when the command is completed or NULL
+ *
+ * @return uint16_t ticket of the command (see isCommandDone) or 0 if the queue is full
+ */
+uint16_t queueCommand(uint8_t cmd, uint8_t argc, const uint8_t *args, uint8_t responseSize, uint8_t *response, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    uint8_t next = (commandQueueTail + 1) % SI473X_CMD_QUEUE_SIZE;
+    si473x_command *c;
+
+    if (next == commandQueueHead || argc > SI473X_CMD_MAX_ARGS)
+        return 0;
+
+    c = &commandQueue[commandQueueTail];
+    c->cmd = cmd;
+    c->argc = argc;
+    memcpy(c->args, args, argc);
+    c->responseSize = (response) ? responseSize : 0;
+    c->response = response;
+    c->callback = callback;
+
+    commandQueueTail = next;
+    if (++commandTicket == 0)
+        commandTicket = 1;
+    return commandTicket;
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Runs one step of the command engine. It never blocks waiting for the device.
+ *
+ * @details Sends the next queued command when the device is clear to send and reads its response when it is ready.
+ * @details A command not completed in MAX_DELAY_COMMAND_TIMEOUT ms is dropped with the ERR bit set.
+ * @details Call it as often as possible (main loop or timer). Do not call blocking functions of this library from an interrupt handler.
+ */
+void processCommandQueue(void)
+{
+    si473x_command *c;
+    si47x_status status;
+    uint8_t dat[SI473X_CMD_MAX_ARGS + 1];
+
+    if (commandEngineBusy || commandQueueHead == commandQueueTail)
+        return;
+    commandEngineBusy = 1;
+
+    c = &commandQueue[commandQueueHead];
+    if (commandEngineState == COMMAND_ENGINE_IDLE)
+    {
+        commandStartTime = transport->millis();
+        commandEngineState = COMMAND_ENGINE_WAIT_CTS;
+    }
+
+    if (!isClearToSend(&status.raw))
+    {
+        if ((transport->millis() - commandStartTime) > MAX_DELAY_COMMAND_TIMEOUT)
+        {
+            status.raw = 0B01000000; // ERR
+            completeCommand(status);
+            return;
+        }
+        commandEngineBusy = 0;
+        return;
+    }
+
+    if (commandEngineState == COMMAND_ENGINE_WAIT_CTS)
+    {
+        dat[0] = c->cmd;
+        memcpy(&dat[1], c->args, c->argc);
+        SI4735_write(dat, c->argc + 1);
+        commandStartTime = transport->millis();
+        commandEngineState = COMMAND_ENGINE_SENT;
+        commandEngineBusy = 0;
+        return;
+    }
+
+    // The command was executed. Gets the response.
+    if (c->responseSize > 0)
+    {
+        SI4735_read(c->response, c->responseSize);
+        status.raw = c->response[0];
+    }
+    completeCommand(status);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Checks if a queued command was completed.
+ *
+ * @param ticket value returned by queueCommand
+ * @return true if the command was completed
+ */
+bool isCommandDone(uint16_t ticket)
+{
+    return (uint16_t)(commandDoneTicket - ticket) < 0x8000;
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Blocks until all queued commands are completed.
+ */
+void flushCommandQueue(void)
+{
+    while (!isCommandQueueEmpty())
+    {
+        processCommandQueue();
+        if (!isCommandQueueEmpty())
+            transport->delayUs(minDelayWaitSendLoop);
+    }
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues a command and waits for its completion (blocking).
+ *
+ * @param cmd          command number
+ * @param argc         number of arguments
+ * @param args         arguments of the command
+ * @param responseSize number of bytes of the response
+ * @param response     byte array where the response will be stored (can be NULL if responseSize is 0)
+ *
+ * @return si47x_status status of the command
+ */
+si47x_status runCommand(uint8_t cmd, uint8_t argc, const uint8_t *args, uint8_t responseSize, uint8_t *response)
+{
+    uint16_t ticket;
+
+    while ((ticket = queueCommand(cmd, argc, args, responseSize, response, NULL)) == 0)
+        processCommandQueue(); // queue is full
+
+    for (;;)
+    {
+        processCommandQueue();
+        if (isCommandDone(ticket))
+            break;
+        transport->delayUs(minDelayWaitSendLoop);
+    }
+    return lastCommandStatus;
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues a SET_PROPERTY command.
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @param param          property value
+ * @param callback       function called when the command is completed or NULL
+ * @return uint16_t ticket of the command or 0 if the queue is full
+ */
+uint16_t queueProperty(uint16_t propertyNumber, uint16_t param, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    si47x_property property, value;
+
+    property.value = propertyNumber;
+    value.value = param;
+    uint8_t args[] = {0, property.raw.byteHigh, property.raw.byteLow, value.raw.byteHigh, value.raw.byteLow};
+    return queueCommand(SET_PROPERTY, sizeof(args), args, 0, NULL, callback);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues the tune status command (FM, AM or NBFM). The response is stored in currentStatus.
+ *
+ * @see getStatus
+ *
+ * @param INTACK   Seek/Tune Interrupt Clear
+ * @param CANCEL   Cancel seek
+ * @param callback function called when the command is completed or NULL
+ * @return uint16_t ticket of the command or 0 if the queue is full
+ */
+uint16_t queueStatus(uint8_t INTACK, uint8_t CANCEL, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    uint8_t cmd, arg, limitResp;
+
+    limitResp = prepareStatusCommand(INTACK, CANCEL, &cmd, &arg);
+    return queueCommand(cmd, 1, &arg, limitResp, currentStatus.raw, callback);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues the RSQ status command. The response is stored in currentRqsStatus.
+ *
+ * @see getCurrentReceivedSignalQuality
+ *
+ * @param INTACK   Interrupt Acknowledge
+ * @param callback function called when the command is completed or NULL
+ * @return uint16_t ticket of the command or 0 if the queue is full
+ */
+uint16_t queueReceivedSignalQuality(uint8_t INTACK, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    uint8_t cmd;
+    uint8_t sizeResponse = prepareRsqCommand(&cmd);
+
+    return queueCommand(cmd, 1, &INTACK, sizeResponse, currentRqsStatus.raw, callback);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues the FM_RDS_STATUS command. The response is stored in currentRdsStatus.
+ *
+ * @see getRdsStatus
+ *
+ * @param INTACK     Interrupt Acknowledge
+ * @param MTFIFO     Empty FIFO
+ * @param STATUSONLY Determines if data should be removed from the RDS FIFO
+ * @param callback   function called when the command is completed or NULL
+ * @return uint16_t ticket of the command or 0 if the queue is full (or not in FM mode)
+ */
+uint16_t queueRdsStatus(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    si47x_rds_command rds_cmd;
+
+    if (currentTune != FM_TUNE_FREQ)
+        return 0;
+
+    rds_cmd.raw = 0;
+    rds_cmd.arg.INTACK = INTACK;
+    rds_cmd.arg.MTFIFO = MTFIFO;
+    rds_cmd.arg.STATUSONLY = STATUSONLY;
+    return queueCommand(FM_RDS_STATUS, 1, &rds_cmd.raw, 13, currentRdsStatus.raw, callback);
+}
+
+/**
+ * @ingroup group21 Command engine
+ *
+ * @brief Queues the tune command of the current function (FM, AM, SSB or NBFM).
+ *
+ * @see setFrequency
+ *
+ * @param freq     frequency to tune
+ * @param callback function called when the command is completed or NULL
+ * @return uint16_t ticket of the command or 0 if the queue is full
+ */
+uint16_t queueFrequency(uint16_t freq, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response))
+{
+    uint8_t args[SI473X_CMD_MAX_ARGS];
+    uint8_t argc = prepareFrequencyArgs(freq, args);
+    uint16_t ticket = queueCommand(currentTune, argc, args, 0, NULL, callback);
+
+    if (ticket)
+        currentWorkFrequency = freq;
+    return ticket;
+}
+
+/** @defgroup group12 FM Mono Stereo audio setup */
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets RSSI threshold for stereo blend (Full stereo above threshold, blend below threshold).
+ *
+ * @details To force stereo, set this to 0. To force mono, set this to 127.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 90.
+ *
+ * @param parameter  valid values: 0 to 127
+ */
+void setFmBlendStereoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_STEREO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets RSSI threshold for mono blend (Full mono below threshold, blend above threshold).
+ *
+ * @details To force stereo set this to 0. To force mono set this to 127. Default value is 30 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 56.
+ *
+ * @param parameter valid values: 0 to 127
+ */
+void setFmBlendMonoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_MONO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets RSSI threshold for stereo blend. (Full stereo above threshold, blend below threshold.)
+ *
+ * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 49 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ *
+ * @param parameter valid values: 0 to 127
+ */
+void setFmBlendRssiStereoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_RSSI_STEREO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets RSSI threshold for mono blend (Full mono below threshold, blend above threshold).
+ *
+ * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 30 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ *
+ * @param parameter valid values: 0 to 127
+ */
+void setFmBLendRssiMonoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_RSSI_MONO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets SNR threshold for stereo blend (Full stereo above threshold, blend below threshold).
+ *
+ * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 27 dB.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ *
+ * @param parameter valid values: 0 to 127
+ */
+void setFmBlendSnrStereoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_SNR_STEREO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets SNR threshold for mono blend (Full mono below threshold, blend above threshold).
+ *
+ * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 14 dB.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ *
+ * @param parameter valid values: 0 to 127
+ */
+void setFmBLendSnrMonoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_SNR_MONO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets multipath threshold for stereo blend (Full stereo below threshold, blend above threshold).
+ *
+ * @details To force stereo, set this to 100. To force mono, set this to 0. Default value is 20.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 60.
+ *
+ * @param parameter valid values: 0 to 100
+ */
+void setFmBlendMultiPathStereoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_MULTIPATH_STEREO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief Sets Multipath threshold for mono blend (Full mono above threshold, blend below threshold).
+ *
+ * @details To force stereo, set to 100. To force mono, set to 0. The default is 60.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 60.
+ *
+ * @param parameter valid values: 0 to 100
+ */
+void setFmBlendMultiPathMonoThreshold(uint8_t parameter)
+{
+    sendProperty(FM_BLEND_MULTIPATH_MONO_THRESHOLD, parameter);
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ * @todo
+ * @brief Turn Off Stereo operation.
+ */
+void setFmStereoOff()
+{
+    //! TO DO
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ * @todo
+ * @brief Turn Off Stereo operation.
+ */
+void setFmStereoOn()
+{
+    //! TO DO
+}
+
+/**
+ * @ingroup group12 FM Mono Stereo audio setup
+ *
+ * @brief There is a debug feature that remains active in Si4704/05/3x-D60 firmware which can create periodic noise in audio.
+ *
+ * @details Silicon Labs recommends you disable this feature by sending the following bytes (shown here in hexadecimal form):
+ * 0x12 0x00 0xFF 0x00 0x00 0x00.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 299.
+ */
+void disableFmDebug()
+{
+    sendProperty(0xFF00, 0);
+}
+
+/** @defgroup group13 Audio setup */
+
+/**
+ * @ingroup group13 Digital Audio setup
+ *
+ * @brief Configures the digital audio output format.
+ *
+ * @details Options: DCLK edge, data format, force mono, and sample precision.
+ *
+ * ATTENTION: The document AN383; "Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; rev 0.8; page 6; there is the following note:
+ *            Crystal and digital audio mode cannot be used at the same time. Populate R1 and remove C10, C11, and X1 when using digital audio.
+ *
+ * @see Si47XX PROGRAMINGGUIDE; AN332 (REV 1.0); page 195.
+ * @see Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; AN383; rev 0.8; page 6;
+
+ * @param uint8_t OSIZE Dgital Output Audio Sample Precision (0=16 bits, 1=20 bits, 2=24 bits, 3=8bits).
+ * @param uint8_t OMONO Digital Output Mono Mode (0=Use mono/stereo blend ).
+ * @param uint8_t OMODE Digital Output Mode (0=I2S, 6 = Left-justified, 8 = MSB at second DCLK after DFS pulse, 12 = MSB at first DCLK after DFS pulse).
+ * @param uint8_t OFALL Digital Output DCLK Edge (0 = use DCLK rising edge, 1 = use DCLK falling edge)
+ */
+void digitalOutputFormat(uint8_t OSIZE, uint8_t OMONO, uint8_t OMODE, uint8_t OFALL)
+{
+    si4735_digital_output_format df;
+    df.refined.OSIZE = OSIZE;
+    df.refined.OMONO = OMONO;
+    df.refined.OMODE = OMODE;
+    df.refined.OFALL = OFALL;
+    df.refined.dummy = 0;
+    sendProperty(DIGITAL_OUTPUT_FORMAT, df.raw);
+}
+
+/**
+ * @ingroup group13 Digital Audio setup
+ *
+ * @brief Enables digital audio output and configures digital audio output sample rate in samples per second (sps).
+ * @details When DOSR[15:0] is 0, digital audio output is disabled. The over-sampling rate must be set in order to
+ * @details satisfy a minimum DCLK of 1 MHz. To enable digital audio output, program DOSR[15:0] with the sample rate
+ * @details in samples per second. The system controller must establish DCLK and DFS prior to enabling the digital
+ * @details audio output else the device will not respond and will require reset. The sample rate must be set to 0
+ * @details before the DCLK/DFS is removed. FM_TUNE_FREQ command must be sent after the POWER_UP command to start
+ * @details the internal clocking before setting this property.
+ *
+ * ATTENTION: The document AN383; "Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; rev 0.8; page 6; there is the following note:
+ *            Crystal and digital audio mode cannot be used at the same time. Populate R1 and remove C10, C11, and X1 when using digital audio.
+ *
+ * @see Si47XX PROGRAMINGGUIDE; AN332 (REV 1.0); page 196.
+ * @see Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES; AN383; rev 0.8; page 6
+ *
+ * @param uint16_t DOSR Digital Output Sample Rate(32–48 ksps .0 to disable digital audio output).
+ */
+void digitalOutputSampleRate(uint16_t DOSR)
+{
+    sendProperty(DIGITAL_OUTPUT_SAMPLE_RATE, DOSR);
+}
+
+/**
+ * @ingroup group13 Audio volume
+ *
+ * @brief Sets volume level (0  to 63)
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 62, 123, 170, 173 and 204
+ *
+ * @param uint8_t volume (domain: 0 - 63)
+ */
+void setVolume(uint8_t volume)
+{
+    sendProperty(RX_VOLUME, volume);
+    volume = volume;
+}
+
+/**
+ * @ingroup group13 Audio volume
+ * @brief Sets the audio on or off.
+ * @details Useful to mute the audio output of the SI47XX device. This function does not work to reduce the pop in the speaker at start the system up.
+ * @details If you want to remove the loud click or pop in the speaker at start, power down and power up commands, use setHardwareAudioMute with a external mute circuit.
+ *
+ * @see See Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 62, 123, 171
+ * @see setHardwareAudioMute
+ *
+ * @param value if true, mute the audio; if false unmute the audio.
+ */
+void setAudioMute(bool off)
+{
+    uint16_t value = (off) ? 3 : 0; // 3 means mute; 0 means unmute
+    sendProperty(RX_HARD_MUTE, value);
+}
+
+/**
+ * @ingroup group13 Aud volume
+ *
+ * @brief Gets the current volume level.
+ *
+ * @see setVolume()
+ *
+ * @return volume (domain: 0 - 63)
+ */
+uint8_t getVolume()
+{
+    return volume;
+}
+
+/**
+ * @ingroup group13 Audio volume
+ *
+ * @brief Set sound volume level Up
+ *
+ * @see setVolume()
+ */
+void volumeUp()
+{
+    if (volume < 63)
+        volume++;
+    setVolume(volume);
+}
+
+/**
+ * @ingroup group13 Audio volume
+ *
+ * @brief Set sound volume level Down
+ *
+ * @see setVolume()
+ */
+void volumeDown()
+{
+    if (volume > 0)
+        volume--;
+    setVolume(volume);
+}
+
+/**
+ * @defgroup group16 FM RDS/RBDS
+ * @todo RDS Dynamic PS or Scrolling PS support
+ */
+
+/*******************************************************************************
+ * RDS implementation
+ ******************************************************************************/
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief  Starts the control member variables for RDS.
+ *
+ * @details This method is called by setRdsConfig()
+ *
+ * @see setRdsConfig()
+ */
+void RdsInit()
+{
+    resetRdsDecoder();
+    rdsTextAdress2A = rdsTextAdress2B = lastTextFlagAB = rdsTextAdress0A = 0;
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Clears the text buffers and the data decoded by processRdsGroup (new station).
+ */
+static void resetRdsDecoder(void)
+{
+    clearRdsBuffer2A();
+    clearRdsBuffer2B();
+    clearRdsBuffer0A();
+    memset(&rdsInfo, 0, sizeof(rdsInfo));
+    memset(&rdsPsVote, 0, sizeof(rdsPsVote));
+    memset(&rdsRtVote, 0, sizeof(rdsRtVote));
+    memset(rdsRtWork, 0, sizeof(rdsRtWork));
+    rdsRtAB = rdsRtVersion = 0;
+    rdsCacheChecked = false;
+    rdsPiCandidate = 0;
+}
+
+static si473x_rds_station rdsCache[SI473X_RDS_CACHE_SIZE]; //!< Stations left by the listener (see setRdsCache)
+static uint16_t rdsCacheClock;                              //!< Incremented on each use of rdsCache (LRU)
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Finds the cache entry of a station.
+ *
+ * @return the entry or NULL
+ */
+static si473x_rds_station *findRdsStation(uint16_t pi, uint16_t frequency)
+{
+    for (uint8_t i = 0; i < SI473X_RDS_CACHE_SIZE; i++)
+        if (rdsCache[i].pi == pi && rdsCache[i].frequency == frequency)
+            return &rdsCache[i];
+    return NULL;
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Stores the data decoded for the station being left (rdsFrequency) on rdsCache.
+ *
+ * @details A station without PI is not stored. Its entry is reused; otherwise a free one or the least recently used.
+ * @details Data not received this time (PS not complete, empty RT or AF list) keeps the cached value.
+ */
+static void storeRdsStation(void)
+{
+    si473x_rds_station *station;
+
+    if (!rdsCacheEnabled || rdsInfo.pi == 0 || rdsFrequency == 0)
+        return;
+    if ((station = findRdsStation(rdsInfo.pi, rdsFrequency)) == NULL)
+    {
+        station = &rdsCache[0];
+        for (uint8_t i = 1; i < SI473X_RDS_CACHE_SIZE && station->pi != 0; i++)
+            if (rdsCache[i].pi == 0 || (uint16_t)(rdsCacheClock - rdsCache[i].lastUsed) > (uint16_t)(rdsCacheClock - station->lastUsed))
+                station = &rdsCache[i];
+        memset(station, 0, sizeof(*station));
+        station->pi = rdsInfo.pi;
+        station->frequency = rdsFrequency;
+    }
+    station->pty = rdsInfo.pty;
+    if (isRdsStationNameComplete()) // A partial PS would be shown as a complete one after the recall
+    {
+        memset(station->ps, 0, sizeof(station->ps));
+        memcpy(station->ps, rds_buffer0A, 8);
+    }
+    if (rds_buffer2A[0] || rds_buffer2B[0])
+    {
+        station->rtVersion = rds_buffer2A[0] ? 0 : 1;
+        strcpy(station->rt, rds_buffer2A[0] ? rds_buffer2A : rds_buffer2B);
+    }
+    if (rdsInfo.afCount)
+    {
+        memcpy(station->af, rdsInfo.af, sizeof(station->af));
+        station->afCount = rdsInfo.afCount;
+    }
+    station->lastUsed = ++rdsCacheClock;
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Shows the cached data of a station (PS, PTY, Radio Text and AF list) before it is received again.
+ *
+ * @details The PS characters are given the votes needed to be shown, so a station that changed its PS
+ * @details replaces them as usual. The Radio Text is replaced by the next one completed.
+ *
+ * @return RDS_NEW_* flags of the data recalled (0 = the station is not on the cache)
+ */
+static uint16_t recallRdsStation(uint16_t pi)
+{
+    si473x_rds_station *station = findRdsStation(pi, rdsFrequency);
+    uint16_t updates = RDS_NEW_CACHED | RDS_NEW_FLAGS;
+
+    if (!rdsCacheEnabled || station == NULL)
+        return 0;
+
+    rdsInfo.pty = station->pty;
+    if (station->ps[0])
+    {
+        strcpy(rds_buffer0A, station->ps);
+        memcpy(rdsPsVote.candidate, station->ps, 8);
+        memset(rdsPsVote.score, rdsTextConfidence, 8);
+        rdsPsVote.confirmed = 0x0F; // isRdsStationNameComplete
+        updates |= RDS_NEW_STATION_NAME;
+    }
+    if (station->rt[0])
+    {
+        strcpy(station->rtVersion ? rds_buffer2B : rds_buffer2A, station->rt);
+        updates |= station->rtVersion ? RDS_NEW_STATION_INFO : RDS_NEW_PROGRAM_INFO;
+    }
+    if (station->afCount)
+    {
+        memcpy(rdsInfo.af, station->af, sizeof(rdsInfo.af));
+        rdsInfo.afCount = station->afCount;
+        updates |= RDS_NEW_AF;
+    }
+    station->lastUsed = ++rdsCacheClock;
+    return updates;
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Removes all stations from the RDS station cache.
+ *
+ * @see setRdsCache
+ */
+void clearRdsCache(void)
+{
+    memset(rdsCache, 0, sizeof(rdsCache));
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Sets RDS property
+ *
+ * @details Configures RDS settings to enable RDS processing (RDSEN) and set RDS block error thresholds.
+ * @details When a RDS Group is received, all block errors must be less than or equal the associated block
+ * error threshold for the group to be stored in the RDS FIFO.
+ * @details IMPORTANT:
+ * All block errors must be less than or equal the associated block error threshold
+ * for the group to be stored in the RDS FIFO.
+ * |Value | Description |
+ * |------| ----------- |
+ * | 0    | No errors |
+ * | 1    | 1–2 bit errors detected and corrected |
+ * | 2    | 3–5 bit errors detected and corrected |
+ * | 3    | Uncorrectable |
+ *
+ * @details Recommended Block Error Threshold options:
+ * | Exemples | Description |
+ * | -------- | ----------- |
+ * | 2,2,2,2  | No group stored if any errors are uncorrected |
+ * | 3,3,3,3  | Group stored regardless of errors |
+ * | 0,0,0,0  | No group stored containing corrected or uncorrected errors |
+ * | 3,2,3,3  | Group stored with corrected errors on B, regardless of errors on A, C, or D |
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 104
+ *
+ * @param uint8_t RDSEN RDS Processing Enable; 1 = RDS processing enabled.
+ * @param uint8_t BLETHA Block Error Threshold BLOCKA.
+ * @param uint8_t BLETHB Block Error Threshold BLOCKB.
+ * @param uint8_t BLETHC Block Error Threshold BLOCKC.
+ * @param uint8_t BLETHD Block Error Threshold BLOCKD.
+ */
+void setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD)
+{
+    si47x_property property;
+    si47x_rds_config config;
+
+    // Set property value
+    property.value = FM_RDS_CONFIG;
+
+    // Arguments
+    config.arg.RDSEN = RDSEN;
+    config.arg.BLETHA = BLETHA;
+    config.arg.BLETHB = BLETHB;
+    config.arg.BLETHC = BLETHC;
+    config.arg.BLETHD = BLETHD;
+    config.arg.DUMMY1 = 0;
+
+    sendProperty(property.value, (config.raw[1] << 8) | config.raw[0]);
+
+    RdsInit();
+}
+
+/**
+ * @ingroup group16 RDS setup
+ *
+ * @brief Configures interrupt related to RDS
+ *
+ * @details Use this method if want to use interrupt
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 103
+ *
+ * @param RDSRECV If set, generate RDSINT when RDS FIFO has at least FM_RDS_INT_FIFO_COUNT entries.
+ * @param RDSSYNCLOST If set, generate RDSINT when RDS loses synchronization.
+ * @param RDSSYNCFOUND set, generate RDSINT when RDS gains synchronization.
+ * @param RDSNEWBLOCKA If set, generate an interrupt when Block A data is found or subsequently changed
+ * @param RDSNEWBLOCKB If set, generate an interrupt when Block B data is found or subsequently changed
+ */
+void setRdsIntSource(uint8_t RDSRECV, uint8_t RDSSYNCLOST, uint8_t RDSSYNCFOUND, uint8_t RDSNEWBLOCKA, uint8_t RDSNEWBLOCKB)
 {
-    sendProperty(FM_SEEK_FREQ_SPACING, spacing);
+    si47x_property property;
+    si47x_rds_int_source rds_int_source;
+
+    if (currentTune != FM_TUNE_FREQ)
+        return;
+
+    rds_int_source.refined.RDSNEWBLOCKB = RDSNEWBLOCKB;
+    rds_int_source.refined.RDSNEWBLOCKA = RDSNEWBLOCKA;
+    rds_int_source.refined.RDSSYNCFOUND = RDSSYNCFOUND;
+    rds_int_source.refined.RDSSYNCLOST = RDSSYNCLOST;
+    rds_int_source.refined.RDSRECV = RDSRECV;
+    rds_int_source.refined.DUMMY1 = 0;
+    rds_int_source.refined.DUMMY2 = 0;
+
+    property.value = FM_RDS_INT_SOURCE;
+
+    sendProperty(property.value, (rds_int_source.raw[1] << 8) | rds_int_source.raw[0]);
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group16 RDS status
  *
- * @brief Sets the RSSI threshold for a valid AM Seek/Tune.
+ * @brief Gets the RDS status. Store the status in currentRdsStatus member. RDS COMMAND FM_RDS_STATUS
  *
- * @details If the value is zero then RSSI threshold is not considered when doing a seek. Default value is 25 dBμV.
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55 and 77
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 127
+ * @param INTACK Interrupt Acknowledge; 0 = RDSINT status preserved. 1 = Clears RDSINT.
+ * @param MTFIFO 0 = If FIFO not empty, read and remove oldest FIFO entry; 1 = Clear RDS Receive FIFO.
+ * @param STATUSONLY Determines if data should be removed from the RDS FIFO.
+ *                   0 = Data in BLOCKA, BLOCKB, BLOCKC, BLOCKD, and BLE contain the oldest data in the RDS FIFO.
+ *                   1 = Data in BLOCKA will contain the last valid block A data received for the cur- rent station. Data in BLOCKB will contain the last valid block B data received for the current station. Data in BLE will describe the bit errors for the data in BLOCKA and BLOCKB.
  */
-void setSeekAmRssiThreshold(uint16_t value)
+void getRdsStatus_t(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY)
 {
-    sendProperty(AM_SEEK_RSSI_THRESHOLD, value);
+    si47x_rds_command rds_cmd;
+    // checking current FUNC (Am or FM)
+    if (currentTune != FM_TUNE_FREQ)
+        return;
+
+    if (rdsFrequency != currentWorkFrequency && !rdsAfCheck)
+        changeRdsFrequency(currentWorkFrequency);
+
+    rds_cmd.raw = 0;
+    rds_cmd.arg.INTACK = INTACK;
+    rds_cmd.arg.MTFIFO = MTFIFO;
+    rds_cmd.arg.STATUSONLY = STATUSONLY;
+
+    runCommand(FM_RDS_STATUS, 1, &rds_cmd.raw, 13, currentRdsStatus.raw);
+    // RDSRECV is latched: the blocks are a new group only if one left the FIFO (an empty FIFO repeats the last one)
+    rdsGroupRemoved = !STATUSONLY && !MTFIFO && currentRdsStatus.resp.RDSFIFOUSED != 0;
+    if (rdsCapture != NULL && rdsGroupRemoved && !rdsAfCheck)
+        captureRdsGroup();
 }
 
 /**
- * @ingroup group08 Seek
- *
- * @brief Sets the RSSI threshold for a valid FM Seek/Tune.
- *
- * @details RSSI threshold which determines if a valid channel has been found during seek/tune. Specified in units of dBμV in 1 dBμV steps (0–127). Default is 20 dBμV.
+ * @ingroup group16 RDS setup
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 102
+ * @brief Stores the data of the station being left on the station cache and clears the decoder for frequency.
  */
-void setSeekFmRssiThreshold(uint16_t value)
+static void changeRdsFrequency(uint16_t frequency)
 {
-    sendProperty(FM_SEEK_TUNE_RSSI_THRESHOLD, value);
+    storeRdsStation();
+    rdsFrequency = frequency;
+    resetRdsDecoder();
 }
 
-/** @defgroup group10 Generic SI473X Command and Property methods
- * @details A set of functions used to support other functions
- */
+// head and tail of si473x_rds_capture: the producer releases the entries it wrote (or the consumer the ones it read)
+// with the store and the other side acquires them with the load.
+#ifdef SI473X_HOST // The consumer can be a thread on another core
+#define RDS_CAPTURE_LOAD(index) __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define RDS_CAPTURE_STORE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+#else // Single core MCU (the consumer is an interrupt or a task): volatile accesses are done in program order
+#define RDS_CAPTURE_LOAD(index) (index)
+#define RDS_CAPTURE_STORE(index, value) ((index) = (value))
+#endif
 
 /**
- * @ingroup group10 Generic send property
- *
- * @brief Sends (sets) property to the SI47XX
- *
- * @details This method is used for others to send generic properties and params to SI47XX
+ * @ingroup group16 RDS capture
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 68, 124 and  133.
- * @see setProperty, sendCommand, getProperty, getCommandResponse
+ * @brief Copies the group of currentRdsStatus to rdsCapture (producer side of the ring).
  *
- * @param propertyNumber property number (example: RX_VOLUME)
- * @param parameter   property value that will be seted
+ * @details The entry is written before head is advanced with a release store (see RDS_CAPTURE_STORE), so the
+ * @details consumer never sees a half written entry. A full ring drops the group (dropped is incremented).
  */
-void sendProperty(uint16_t propertyNumber, uint16_t parameter)
+static void captureRdsGroup(void)
 {
-    si47x_property property;
-    si47x_property param;
+    uint16_t head = rdsCapture->head;
+    volatile si473x_rds_raw_group *entry;
 
-    property.value = propertyNumber;
-    param.value = parameter;
-    waitToSend();
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, param.raw.byteHigh, param.raw.byteLow};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(1);
+    if ((uint16_t)(head - RDS_CAPTURE_LOAD(rdsCapture->tail)) >= SI473X_RDS_CAPTURE_SIZE)
+    {
+        rdsCapture->dropped++;
+        return;
+    }
+    entry = &rdsCapture->groups[head % SI473X_RDS_CAPTURE_SIZE];
+    entry->timestamp = transport->millis();
+    entry->frequency = currentWorkFrequency;
+    entry->block[0] = (uint16_t)currentRdsStatus.resp.BLOCKAH << 8 | currentRdsStatus.resp.BLOCKAL;
+    entry->block[1] = (uint16_t)currentRdsStatus.resp.BLOCKBH << 8 | currentRdsStatus.resp.BLOCKBL;
+    entry->block[2] = (uint16_t)currentRdsStatus.resp.BLOCKCH << 8 | currentRdsStatus.resp.BLOCKCL;
+    entry->block[3] = (uint16_t)currentRdsStatus.resp.BLOCKDH << 8 | currentRdsStatus.resp.BLOCKDL;
+    entry->ble = currentRdsStatus.resp.BLEA << 6 | currentRdsStatus.resp.BLEB << 4 | currentRdsStatus.resp.BLEC << 2 | currentRdsStatus.resp.BLED;
+    RDS_CAPTURE_STORE(rdsCapture->head, (uint16_t)(head + 1));
 }
 
 /**
- * @ingroup group10 Generic Command and Response
- * @brief Sends a given command to the SI47XX devices.
- * @details This function can be useful when you want to execute a SI47XX device command and it was not implemented by this library.
- * @details In this case you have to check the  AN332-Si47XX PROGRAMMING GUIDE to know how the command works.
- * @details Also, you need to work with bit operators to compose the parameters of the command [ &(and), ˆ(xor), |(or) etc ].
+ * @ingroup group16 RDS capture
  *
- * @see getCommandResponse, setProperty
+ * @brief Starts copying the raw RDS groups read from the device to a ring buffer.
  *
- * @param cmd command number (see AN332-Si47XX PROGRAMMING GUIDE)
- * @param parameter_size Parameter size in bytes. Tell the number of argument used by the command.
- * @param parameter unsigned byte array with the arguments of the command
+ * @details Every group removed from the RDS FIFO (drainRdsFifo, getRdsStatus, ...) is stored with its block errors,
+ * @details the frequency and the time (ms) it was read. Groups read by processAfSwitch on an AF are not stored.
+ * @details The driver is the only producer; readRdsCapture is the consumer and can run on an interrupt or another
+ * @details task without locks. Use formatRdsGroup to send the groups to a PC and replayRdsGroup to decode them again.
+ * @code
+ * static si473x_rds_capture capture;
+ * si473x_rds_raw_group group;
+ * char line[SI473X_RDS_GROUP_LINE];
+ * startRdsCapture(&capture);
+ * for (;;)
+ * {
+ *     drainRdsFifo(&updates);
+ *     while (readRdsCapture(&capture, &group, 1))
+ *         uartSend(formatRdsGroup(&group, line));
+ * }
+ * @endcode
+ *
+ * @see readRdsCapture, formatRdsGroup, replayRdsGroup
+ *
+ * @param capture ring buffer (NULL stops the capture)
  */
-void sendCommand(uint8_t cmd, int parameter_size, const uint8_t *parameter)
+void startRdsCapture(si473x_rds_capture *capture)
 {
-    waitToSend();
-    uint8_t *dat = (uint8_t *)calloc(1, parameter_size + 1);
-    if (dat) {
-    	*dat = cmd;
-    	memcpy(dat + 1, parameter, parameter_size);
-        SI4735_write(dat, parameter_size + 1);
-        free(dat);
+    if (capture != NULL)
+    {
+        capture->head = capture->tail = 0;
+        capture->dropped = 0;
     }
+    rdsCapture = capture;
 }
 
 /**
- * @ingroup group10 Generic Command and Response
- * @brief   Returns with the command response.
- * @details After a command is executed by the device, you can get the result (response) of the command by calling this method.
+ * @ingroup group16 RDS capture
  *
- * @see sendCommand, setProperty
+ * @brief Removes the oldest groups from a capture ring buffer (consumer side of the ring).
  *
- * @param response_size  num of bytes returned by the command.
- * @param response  byte array where the response will be stored.
+ * @details head is read with an acquire load and tail is advanced with a release store (see RDS_CAPTURE_LOAD),
+ * @details so it can run on a thread of another core on a PC. Only one consumer may read a ring.
+ *
+ * @param capture ring buffer given to startRdsCapture
+ * @param groups  where the groups are copied
+ * @param max     size of groups
+ * @return number of groups copied
  */
-void getCommandResponse(int response_size, uint8_t *response)
+uint16_t readRdsCapture(si473x_rds_capture *capture, si473x_rds_raw_group *groups, uint16_t max)
 {
-    waitToSend();
-	SI4735_read(response, response_size);
+    uint16_t tail = capture->tail;
+    uint16_t head = RDS_CAPTURE_LOAD(capture->head);
+    uint16_t count = 0;
+
+    while (count < max && tail != head)
+        groups[count++] = capture->groups[tail++ % SI473X_RDS_CAPTURE_SIZE];
+    RDS_CAPTURE_STORE(capture->tail, tail);
+    return count;
 }
 
+static const char rdsHexDigits[] = "0123456789ABCDEF";
+
 /**
- * @ingroup group10 Generic Command and Response
- * @brief Gets the first byte response.
- * @details In this context status is the first response byte for any SI47XX command. See si47x_status structure.
- * @details This function can be useful to check, for example, the success or failure of a command.
- *
- * @see si47x_status
+ * @ingroup group16 RDS capture
  *
- * @return si47x_status
+ * @brief Writes value as digits hexadecimal digits.
  */
-si47x_status getStatusResponse()
+static char *formatRdsHex(char *line, uint32_t value, uint8_t digits)
 {
-    si47x_status status;
-
-    SI4735_read(&status.raw, 1);
-
-    return status;
+    while (digits--)
+        *line++ = rdsHexDigits[(value >> (digits * 4)) & 0x0F];
+    return line;
 }
 
 /**
- * @ingroup group10 Generic get property
- *
- * @brief Gets a given property from the SI47XX
- *
- * @details This method is used to get a given property from SI47XX
- * @details You might need to extract set of bits information from the returned value to know the real value
+ * @ingroup group16 RDS capture
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 69, 124 and  134.
- * @see sendProperty, setProperty, sendCommand, getCommandResponse
+ * @brief Converts a raw group to a text line: timestamp, frequency, blocks A to D and BLE (all hexadecimal).
  *
- * @param propertyNumber property number (example: RX_VOLUME)
+ * @details Example: "0001A2F4 28BE E505 00A0 E134 524F 00" (a fixed size line, without sprintf).
  *
- * @return property value  (the content of the property)
+ * @param group raw group
+ * @param line  at least SI473X_RDS_GROUP_LINE characters
+ * @return line
  */
-int32_t
-getProperty(uint16_t propertyNumber)
+char *formatRdsGroup(const si473x_rds_raw_group *group, char *line)
 {
-    si47x_property property;
-    si47x_status status;
-
-    property.value = propertyNumber;
-    waitToSend();
-    uint8_t dat[] = {GET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow};
-    SI4735_write(dat, sizeof(dat));
+    char *p = formatRdsHex(line, group->timestamp, 8);
 
-    waitToSend();
-    SI4735_read(dat, 4);
-    status.raw = dat[0];
-
-    // if error, return 0;
-    if (status.refined.ERR == 1)
-        return -1;
-
-    //SI473X_read(); // dummy
-
-    // gets the property value
-    property.raw.byteHigh = dat[2];//Wire.read();
-    property.raw.byteLow = dat[3];//Wire.read();
-
-    return property.value;
+    *p++ = ' ';
+    p = formatRdsHex(p, group->frequency, 4);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        *p++ = ' ';
+        p = formatRdsHex(p, group->block[i], 4);
+    }
+    *p++ = ' ';
+    p = formatRdsHex(p, group->ble, 2);
+    *p++ = '\n';
+    *p = '\0';
+    return line;
 }
 
-/** @defgroup group12 FM Mono Stereo audio setup */
-
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets RSSI threshold for stereo blend (Full stereo above threshold, blend below threshold).
+ * @ingroup group16 RDS capture
  *
- * @details To force stereo, set this to 0. To force mono, set this to 127.
- *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 90.
+ * @brief Reads the hexadecimal field of a line written by formatRdsGroup.
  *
- * @param parameter  valid values: 0 to 127
+ * @return false if a character is not an hexadecimal digit
  */
-void setFmBlendStereoThreshold(uint8_t parameter)
+static bool parseRdsHex(const char **line, uint32_t *value, uint8_t digits)
 {
-    sendProperty(FM_BLEND_STEREO_THRESHOLD, parameter);
+    *value = 0;
+    while (**line == ' ')
+        (*line)++;
+    while (digits--)
+    {
+        const char *d = strchr(rdsHexDigits, (**line >= 'a' && **line <= 'f') ? **line - 32 : **line);
+        if (**line == '\0' || d == NULL)
+            return false;
+        *value = *value << 4 | (uint32_t)(d - rdsHexDigits);
+        (*line)++;
+    }
+    return true;
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets RSSI threshold for mono blend (Full mono below threshold, blend above threshold).
- *
- * @details To force stereo set this to 0. To force mono set this to 127. Default value is 30 dBμV.
+ * @ingroup group16 RDS capture
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 56.
+ * @brief Converts a line written by formatRdsGroup back to a raw group.
  *
- * @param parameter valid values: 0 to 127
+ * @param line  text line
+ * @param group raw group
+ * @return false if the line is not a group
  */
-void setFmBlendMonoThreshold(uint8_t parameter)
+bool parseRdsGroup(const char *line, si473x_rds_raw_group *group)
 {
-    sendProperty(FM_BLEND_MONO_THRESHOLD, parameter);
+    uint32_t value;
+
+    if (!parseRdsHex(&line, &group->timestamp, 8) || !parseRdsHex(&line, &value, 4))
+        return false;
+    group->frequency = (uint16_t)value;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (!parseRdsHex(&line, &value, 4))
+            return false;
+        group->block[i] = (uint16_t)value;
+    }
+    if (!parseRdsHex(&line, &value, 2))
+        return false;
+    group->ble = (uint8_t)value;
+    return true;
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets RSSI threshold for stereo blend. (Full stereo above threshold, blend below threshold.)
+ * @ingroup group16 RDS capture
  *
- * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 49 dBμV.
+ * @brief Decodes a recorded group as if it had been read from the device (processRdsGroup).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ * @details A new frequency clears the decoder as a tune does. No command is sent to the device, so the
+ * @details decoder can be tested or benchmarked on a PC with groups recorded by startRdsCapture.
  *
- * @param parameter valid values: 0 to 127
+ * @param group raw group (see parseRdsGroup)
+ * @return RDS_NEW_* flags of the data changed by the group
  */
-void setFmBlendRssiStereoThreshold(uint8_t parameter)
+uint16_t replayRdsGroup(const si473x_rds_raw_group *group)
 {
-    sendProperty(FM_BLEND_RSSI_STEREO_THRESHOLD, parameter);
+    if (group->frequency != rdsFrequency)
+        changeRdsFrequency(group->frequency);
+
+    memset(&currentRdsStatus, 0, sizeof(currentRdsStatus));
+    currentRdsStatus.resp.RDSRECV = 1;
+    currentRdsStatus.resp.RDSFIFOUSED = 1;
+    currentRdsStatus.resp.BLOCKAH = group->block[0] >> 8;
+    currentRdsStatus.resp.BLOCKAL = group->block[0] & 0xFF;
+    currentRdsStatus.resp.BLOCKBH = group->block[1] >> 8;
+    currentRdsStatus.resp.BLOCKBL = group->block[1] & 0xFF;
+    currentRdsStatus.resp.BLOCKCH = group->block[2] >> 8;
+    currentRdsStatus.resp.BLOCKCL = group->block[2] & 0xFF;
+    currentRdsStatus.resp.BLOCKDH = group->block[3] >> 8;
+    currentRdsStatus.resp.BLOCKDL = group->block[3] & 0xFF;
+    currentRdsStatus.resp.BLEA = group->ble >> 6;
+    currentRdsStatus.resp.BLEB = (group->ble >> 4) & 0x03;
+    currentRdsStatus.resp.BLEC = (group->ble >> 2) & 0x03;
+    currentRdsStatus.resp.BLED = group->ble & 0x03;
+    rdsGroupRemoved = true;
+    return processRdsGroup();
 }
 
+#ifdef SI473X_HOST
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets RSSI threshold for mono blend (Full mono below threshold, blend above threshold).
- *
- * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 30 dBμV.
+ * @ingroup group16 RDS capture
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ * @brief Writes the groups waiting on a capture ring buffer to a file (one formatRdsGroup line each).
  *
- * @param parameter valid values: 0 to 127
+ * @param capture ring buffer given to startRdsCapture
+ * @param file    text file opened for writing
+ * @return groups written
  */
-void setFmBLendRssiMonoThreshold(uint8_t parameter)
+uint32_t saveRdsCapture(si473x_rds_capture *capture, FILE *file)
 {
-    sendProperty(FM_BLEND_RSSI_MONO_THRESHOLD, parameter);
+    si473x_rds_raw_group group;
+    char line[SI473X_RDS_GROUP_LINE];
+    uint32_t count = 0;
+
+    while (readRdsCapture(capture, &group, 1))
+    {
+        fputs(formatRdsGroup(&group, line), file);
+        count++;
+    }
+    return count;
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets SNR threshold for stereo blend (Full stereo above threshold, blend below threshold).
+ * @ingroup group16 RDS capture
  *
- * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 27 dB.
+ * @brief Replays a file written by saveRdsCapture through the RDS decoder (see replayRdsGroup).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ * @details Lines that are not groups (comments, for example) are skipped.
  *
- * @param parameter valid values: 0 to 127
+ * @param file    text file opened for reading
+ * @param onGroup called after each group with the RDS_NEW_* flags it produced (NULL = none)
+ * @return groups replayed
  */
-void setFmBlendSnrStereoThreshold(uint8_t parameter)
+uint32_t replayRdsFile(FILE *file, void (*onGroup)(const si473x_rds_raw_group *group, uint16_t updates))
 {
-    sendProperty(FM_BLEND_SNR_STEREO_THRESHOLD, parameter);
+    si473x_rds_raw_group group;
+    char line[80];
+    uint32_t count = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        uint16_t updates;
+        if (!parseRdsGroup(line, &group))
+            continue;
+        updates = replayRdsGroup(&group);
+        if (onGroup != NULL)
+            onGroup(&group, updates);
+        count++;
+    }
+    return count;
 }
+#endif
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets SNR threshold for mono blend (Full mono below threshold, blend above threshold).
+ * @ingroup group16 RDS status
  *
- * @details To force stereo, set this to 0. To force mono, set this to 127. Default value is 14 dB.
+ * @brief Votes a received character of a PS or RT segment (see setRdsTextConfidence).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 59.
+ * @param vote    votes of the text
+ * @param text    text buffer (rds_buffer0A or rds_buffer2A)
+ * @param index   position of the character
+ * @param c       character received
+ * @param ble     block error level of the block that carried c (0 to 2)
+ * @return true if the character shown on text changed
+ */
+static bool voteRdsChar(si473x_rds_text_vote *vote, char *text, uint8_t index, char c, uint8_t ble)
+{
+    uint8_t weight = (ble == 0) ? 2 : 1;
+
+    if (rdsTextConfidence == 0)
+        vote->candidate[index] = c;
+    else if (vote->candidate[index] == c)
+        vote->score[index] = (vote->score[index] + weight > rdsTextConfidence) ? rdsTextConfidence : vote->score[index] + weight; // Capped: a new text (dynamic PS) wins in a few groups
+    else if (vote->score[index] > weight)
+        vote->score[index] -= weight;
+    else
+    {
+        vote->candidate[index] = c;
+        vote->score[index] = weight;
+    }
+
+    if (vote->score[index] < rdsTextConfidence || text[index] == vote->candidate[index])
+        return false;
+    text[index] = vote->candidate[index];
+    return true;
+}
+
+/**
+ * @ingroup group16 RDS status
  *
- * @param parameter valid values: 0 to 127
+ * @brief Sets or clears the confirmed bit of a segment after its characters were voted.
  */
-void setFmBLendSnrMonoThreshold(uint8_t parameter)
+static void confirmRdsSegment(si473x_rds_text_vote *vote, uint8_t segment, uint8_t size)
 {
-    sendProperty(FM_BLEND_SNR_MONO_THRESHOLD, parameter);
+    uint8_t i;
+
+    for (i = segment * size; i < (segment + 1) * size && vote->score[i] >= rdsTextConfidence; i++)
+        ;
+    if (i == (segment + 1) * size)
+        vote->confirmed |= 1 << segment;
+    else
+        vote->confirmed &= ~(1 << segment);
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
+ * @ingroup group16 RDS status
  *
- * @brief Sets multipath threshold for stereo blend (Full stereo below threshold, blend above threshold).
+ * @brief Adds an AF code to rdsInfo.af.
  *
- * @details To force stereo, set this to 100. To force mono, set this to 0. Default value is 20.
+ * @return RDS_NEW_AF if the code is a frequency not on the list; 0 otherwise
+ */
+static uint16_t addRdsAf(uint8_t code)
+{
+    uint8_t k;
+
+    if (code < 1 || code > 204) // 205 = filler; 224 to 249 = number of AFs; 250 = LF/MF follows
+        return 0;
+    for (k = 0; k < rdsInfo.afCount && rdsInfo.af[k] != code; k++)
+        ;
+    if (k == rdsInfo.afCount && k < SI473X_RDS_AF_SIZE)
+    {
+        rdsInfo.af[rdsInfo.afCount++] = code;
+        return RDS_NEW_AF;
+    }
+    return 0;
+}
+
+/**
+ * @ingroup group16 RDS status
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 60.
+ * @brief Decodes the pair of AF codes of a 0A group (block C).
  *
- * @param parameter valid values: 0 to 100
+ * @details A list starts with the number of AFs (224 to 249). When the code after it is the tuned frequency, the
+ * @details station uses method B: each list belongs to one transmitter and its pairs hold the tuned frequency and an AF
+ * @details (ascending pair = same program; descending = regional variant, not kept). Pairs of the lists of other
+ * @details transmitters are ignored. Otherwise (method A) all codes are AFs of the station.
  */
-void setFmBlendMultiPathStereoThreshold(uint8_t parameter)
+static uint16_t decodeRdsAf(uint8_t first, uint8_t second)
 {
-    sendProperty(FM_BLEND_MULTIPATH_STEREO_THRESHOLD, parameter);
+    uint8_t tuned = (rdsFrequency > 8750 && rdsFrequency <= 10790) ? (rdsFrequency - 8750) / 10 : 0;
+
+    if (first == 250) // LF/MF frequency follows
+        return 0;
+    if (first >= 224 && first <= 249)
+    {
+        if (tuned && second == tuned)
+            rdsInfo.afMethod = RDS_AF_METHOD_B;
+        else if (rdsInfo.afMethod != RDS_AF_METHOD_B)
+            rdsInfo.afMethod = RDS_AF_METHOD_A;
+        return (rdsInfo.afMethod == RDS_AF_METHOD_A) ? addRdsAf(second) : 0;
+    }
+    if (rdsInfo.afMethod == RDS_AF_METHOD_B)
+    {
+        if (first == tuned && second > tuned)
+            return addRdsAf(second);
+        if (second == tuned && first < tuned)
+            return addRdsAf(first);
+        return 0;
+    }
+    return addRdsAf(first) | addRdsAf(second);
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- *
- * @brief Sets Multipath threshold for mono blend (Full mono above threshold, blend below threshold).
- *
- * @details To force stereo, set to 100. To force mono, set to 0. The default is 60.
- *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 60.
+ * @ingroup group16 RDS status
  *
- * @param parameter valid values: 0 to 100
+ * @brief Groups 0A and 0B: PS segment (block D), TA, MS, DI and the AF codes of 0A (block C).
  */
-void setFmBlendMultiPathMonoThreshold(uint8_t parameter)
+static uint16_t rdsDecode0(const si473x_rds_group *group)
 {
-    sendProperty(FM_BLEND_MULTIPATH_MONO_THRESHOLD, parameter);
+    uint16_t updates = 0;
+    uint8_t address = group->blockB.group0.address;
+    uint8_t di = (rdsInfo.di & ~(1 << (3 - address))) | (group->blockB.group0.DI << (3 - address)); // Segment 0 carries d3
+
+    if (rdsInfo.ta != group->blockB.group0.TA || rdsInfo.ms != group->blockB.group0.MS || rdsInfo.di != di)
+    {
+        rdsInfo.ta = group->blockB.group0.TA;
+        rdsInfo.ms = group->blockB.group0.MS;
+        rdsInfo.di = di;
+        updates |= RDS_NEW_FLAGS;
+    }
+    if (group->blockB.group0.versionCode == 0 && group->ble[2] == 0) // A corrected AF code could add a wrong AF
+        updates |= decodeRdsAf(group->blockC >> 8, group->blockC & 0xFF);
+    if (group->ble[3] < 3)
+    {
+        bool changed = voteRdsChar(&rdsPsVote, rds_buffer0A, address * 2, group->blockD >> 8, group->ble[3]);
+        changed |= voteRdsChar(&rdsPsVote, rds_buffer0A, address * 2 + 1, group->blockD & 0xFF, group->ble[3]);
+        confirmRdsSegment(&rdsPsVote, address, 2);
+        rds_buffer0A[8] = '\0';
+        rdsTextAdress0A = address;
+        if (changed)
+            updates |= RDS_NEW_STATION_NAME;
+    }
+    return updates;
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- * @todo
- * @brief Turn Off Stereo operation.
+ * @ingroup group16 RDS status
+ *
+ * @brief Group 1A: Extended Country Code (variant 0 of block C) and Program Item Number (block D).
  */
-void setFmStereoOff()
+static uint16_t rdsDecode1A(const si473x_rds_group *group)
 {
-    //! TO DO
+    uint16_t updates = 0;
+
+    if (group->ble[2] < 3 && ((group->blockC >> 12) & 0x07) == 0 && rdsInfo.ecc != (group->blockC & 0xFF))
+    {
+        rdsInfo.ecc = group->blockC & 0xFF;
+        updates |= RDS_NEW_PIN;
+    }
+    if (group->ble[3] < 3 && rdsInfo.pin != group->blockD)
+    {
+        rdsInfo.pin = group->blockD;
+        updates |= RDS_NEW_PIN;
+    }
+    return updates;
 }
 
+static void (*rdsTextHandler)(const char *text, uint8_t versionCode, uint8_t textAB) = NULL; //!< See setRdsTextHandler
+
 /**
- * @ingroup group12 FM Mono Stereo audio setup
- * @todo
- * @brief Turn Off Stereo operation.
+ * @ingroup group16 RDS status
+ *
+ * @brief Checks if all segments of the Radio Text on rdsRtWork reached the confidence.
+ *
+ * @details The text ends on the segment that holds the 0x0D end mark or on the last segment (15).
  */
-void setFmStereoOn()
+static bool isRdsTextWorkComplete(void)
 {
-    //! TO DO
+    uint8_t size = rdsRtVersion ? 2 : 4;
+    char *end = memchr(rdsRtWork, 0x0D, size * 16);
+    uint8_t last = (end != NULL) ? (end - rdsRtWork) / size : 15;
+    uint16_t segments = (uint16_t)((1UL << (last + 1)) - 1);
+
+    return (rdsRtVote.confirmed & segments) == segments;
 }
 
 /**
- * @ingroup group12 FM Mono Stereo audio setup
+ * @ingroup group16 RDS status
  *
- * @brief There is a debug feature that remains active in Si4704/05/3x-D60 firmware which can create periodic noise in audio.
+ * @brief Copies rdsRtWork to the published buffer (rds_buffer2A or rds_buffer2B).
  *
- * @details Silicon Labs recommends you disable this feature by sending the following bytes (shown here in hexadecimal form):
- * 0x12 0x00 0xFF 0x00 0x00 0x00.
+ * @details The text is cut at the 0x0D end mark; characters not received yet are shown as spaces.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 299.
+ * @return RDS_NEW_PROGRAM_INFO or RDS_NEW_STATION_INFO if the published text changed; 0 otherwise
  */
-void disableFmDebug()
+static uint16_t publishRdsText(void)
 {
-    uint8_t dat[] = {0x12, 0, 0xff, 0, 0, 0};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(3);
+    char text[65] = {0};
+    char *published = rdsRtVersion ? rds_buffer2B : rds_buffer2A;
+    uint8_t size = rdsRtVersion ? 32 : 64;
+
+    for (uint8_t i = 0; i < size && rdsRtWork[i] != 0x0D; i++)
+        text[i] = rdsRtWork[i] ? rdsRtWork[i] : ' ';
+    if (memcmp(published, text, size + 1) == 0)
+        return 0;
+    memcpy(published, text, size + 1);
+    if (rdsTextHandler != NULL)
+        rdsTextHandler(published, rdsRtVersion, rdsRtAB);
+    return rdsRtVersion ? RDS_NEW_STATION_INFO : RDS_NEW_PROGRAM_INFO;
 }
 
-/** @defgroup group13 Audio setup */
-
 /**
- * @ingroup group13 Digital Audio setup
- *
- * @brief Configures the digital audio output format.
- *
- * @details Options: DCLK edge, data format, force mono, and sample precision.
+ * @ingroup group16 RDS status
  *
- * ATTENTION: The document AN383; "Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; rev 0.8; page 6; there is the following note:
- *            Crystal and digital audio mode cannot be used at the same time. Populate R1 and remove C10, C11, and X1 when using digital audio.
+ * @brief Groups 2A (4 characters on blocks C and D) and 2B (2 characters on block D).
  *
- * @see Si47XX PROGRAMINGGUIDE; AN332 (REV 1.0); page 195.
- * @see Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; AN383; rev 0.8; page 6;
-
- * @param uint8_t OSIZE Dgital Output Audio Sample Precision (0=16 bits, 1=20 bits, 2=24 bits, 3=8bits).
- * @param uint8_t OMONO Digital Output Mono Mode (0=Use mono/stereo blend ).
- * @param uint8_t OMODE Digital Output Mode (0=I2S, 6 = Left-justified, 8 = MSB at second DCLK after DFS pulse, 12 = MSB at first DCLK after DFS pulse).
- * @param uint8_t OFALL Digital Output DCLK Edge (0 = use DCLK rising edge, 1 = use DCLK falling edge)
+ * @details The text is assembled on rdsRtWork and published when all its segments are confirmed or when
+ * @details the station starts a new text (A/B flag toggled or the other version received).
  */
-void digitalOutputFormat(uint8_t OSIZE, uint8_t OMONO, uint8_t OMODE, uint8_t OFALL)
+static uint16_t rdsDecode2(const si473x_rds_group *group)
 {
-    si4735_digital_output_format df;
-    df.refined.OSIZE = OSIZE;
-    df.refined.OMONO = OMONO;
-    df.refined.OMODE = OMODE;
-    df.refined.OFALL = OFALL;
-    df.refined.dummy = 0;
-    sendProperty(DIGITAL_OUTPUT_FORMAT, df.raw);
+    uint16_t updates = 0;
+    uint8_t address = group->blockB.group2.address;
+    uint8_t version = group->blockB.group2.versionCode;
+
+    if (group->ble[3] == 3 || (version == 0 && group->ble[2] == 3))
+        return 0;
+
+    if (rdsRtAB != group->blockB.group2.textABFlag || rdsRtVersion != version)
+    {
+        if (rdsRtVote.confirmed) // Part of the previous text was confirmed
+            updates |= publishRdsText();
+        memset(rdsRtWork, 0, sizeof(rdsRtWork));
+        memset(&rdsRtVote, 0, sizeof(rdsRtVote));
+        rdsRtAB = group->blockB.group2.textABFlag;
+        rdsRtVersion = version;
+    }
+
+    if (version == 1)
+    {
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 2, group->blockD >> 8, group->ble[3]);
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 2 + 1, group->blockD & 0xFF, group->ble[3]);
+        confirmRdsSegment(&rdsRtVote, address, 2);
+        rdsTextAdress2B = address;
+    }
+    else
+    {
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 4, group->blockC >> 8, group->ble[2]);
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 4 + 1, group->blockC & 0xFF, group->ble[2]);
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 4 + 2, group->blockD >> 8, group->ble[3]);
+        voteRdsChar(&rdsRtVote, rdsRtWork, address * 4 + 3, group->blockD & 0xFF, group->ble[3]);
+        confirmRdsSegment(&rdsRtVote, address, 4);
+        rdsTextAdress2A = address;
+    }
+
+    if (isRdsTextWorkComplete())
+        updates |= publishRdsText();
+    return updates;
 }
 
 /**
- * @ingroup group13 Digital Audio setup
- *
- * @brief Enables digital audio output and configures digital audio output sample rate in samples per second (sps).
- * @details When DOSR[15:0] is 0, digital audio output is disabled. The over-sampling rate must be set in order to
- * @details satisfy a minimum DCLK of 1 MHz. To enable digital audio output, program DOSR[15:0] with the sample rate
- * @details in samples per second. The system controller must establish DCLK and DFS prior to enabling the digital
- * @details audio output else the device will not respond and will require reset. The sample rate must be set to 0
- * @details before the DCLK/DFS is removed. FM_TUNE_FREQ command must be sent after the POWER_UP command to start
- * @details the internal clocking before setting this property.
+ * @ingroup group16 RDS status
  *
- * ATTENTION: The document AN383; "Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES"; rev 0.8; page 6; there is the following note:
- *            Crystal and digital audio mode cannot be used at the same time. Populate R1 and remove C10, C11, and X1 when using digital audio.
+ * @brief Checks if all characters of the Radio Text being received reached the confidence
  *
- * @see Si47XX PROGRAMINGGUIDE; AN332 (REV 1.0); page 196.
- * @see Si47XX ANTENNA, SCHEMATIC, LAYOUT, AND DESIGN GUIDELINES; AN383; rev 0.8; page 6
+ * @details The text ends on the segment that holds the 0x0D end mark or on the last segment.
+ * @details A complete text is already on rds_buffer2A (2A) or rds_buffer2B (2B).
  *
- * @param uint16_t DOSR Digital Output Sample Rate(32–48 ksps .0 to disable digital audio output).
+ * @return true when every segment of the text is confirmed
+ * @see setRdsTextConfidence, setRdsTextHandler
  */
-void digitalOutputSampleRate(uint16_t DOSR)
+bool isRdsProgramInfoComplete(void)
 {
-    sendProperty(DIGITAL_OUTPUT_SAMPLE_RATE, DOSR);
+    return isRdsTextWorkComplete();
 }
 
 /**
- * @ingroup group13 Audio volume
+ * @ingroup group16 RDS status
  *
- * @brief Sets volume level (0  to 63)
+ * @brief Sets the function called when a new Radio Text is published on rds_buffer2A or rds_buffer2B.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 62, 123, 170, 173 and 204
+ * @details The text is published when all its segments are confirmed (see setRdsTextConfidence) or when the
+ * @details station starts another one (A/B flag). The handler is only called when the published text changes;
+ * @details processRdsGroup also returns RDS_NEW_PROGRAM_INFO (2A) or RDS_NEW_STATION_INFO (2B) for it.
  *
- * @param uint8_t volume (domain: 0 - 63)
+ * @param handler receives the text (without the 0x0D end mark), the version (0 = 2A; 1 = 2B) and the A/B flag
  */
-void setVolume(uint8_t volume)
+void setRdsTextHandler(void (*handler)(const char *text, uint8_t versionCode, uint8_t textAB))
 {
-    sendProperty(RX_VOLUME, volume);
-    volume = volume;
+    rdsTextHandler = handler;
 }
 
+static void (*rdsOdaHandler)(uint16_t aid, uint8_t group, uint16_t message) = NULL; //!< See setRdsOdaHandler
+
 /**
- * @ingroup group13 Audio volume
- * @brief Sets the audio on or off.
- * @details Useful to mute the audio output of the SI47XX device. This function does not work to reduce the pop in the speaker at start the system up.
- * @details If you want to remove the loud click or pop in the speaker at start, power down and power up commands, use setHardwareAudioMute with a external mute circuit.
- *
- * @see See Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 62, 123, 171
- * @see setHardwareAudioMute
+ * @ingroup group16 RDS status
  *
- * @param value if true, mute the audio; if false unmute the audio.
+ * @brief Group 3A: Open Data Application announcement (AID on block D; group used by the ODA on block B).
  */
-void setAudioMute(bool off)
+static uint16_t rdsDecode3A(const si473x_rds_group *group)
 {
-    uint16_t value = (off) ? 3 : 0; // 3 means mute; 0 means unmute
-    sendProperty(RX_HARD_MUTE, value);
+    if (group->ble[3] == 3)
+        return 0;
+    if (rdsOdaHandler != NULL)
+        rdsOdaHandler(group->blockD, group->blockB.refined.textABFlag << 4 | group->blockB.refined.content, group->blockC); // Bits 4-1: type; bit 0: version
+    return RDS_NEW_ODA;
 }
 
 /**
- * @ingroup group13 Aud volume
- *
- * @brief Gets the current volume level.
- *
- * @see setVolume()
+ * @ingroup group16 RDS status
  *
- * @return volume (domain: 0 - 63)
+ * @brief Group 4A: UTC time and offset (see getRdsTime).
  */
-uint8_t getVolume()
+static uint16_t rdsDecode4A(const si473x_rds_group *group)
 {
-    return volume;
+    if (group->ble[2] == 3 || group->ble[3] == 3)
+        return 0;
+    return (decodeRdsTime((uint16_t)group->blockB.raw.highValue << 8 | group->blockB.raw.lowValue, group->blockC, group->blockD) != NULL) ? RDS_NEW_TIME : 0;
 }
 
 /**
- * @ingroup group13 Audio volume
- *
- * @brief Set sound volume level Up
+ * @ingroup group16 RDS status
  *
- * @see setVolume()
+ * @brief Group 10A: Program Type Name (2 segments of 4 characters; the A/B flag restarts the name).
  */
-void volumeUp()
+static uint16_t rdsDecode10A(const si473x_rds_group *group)
 {
-    if (volume < 63)
-        volume++;
-    setVolume(volume);
+    uint8_t address = group->blockB.refined.content & 0x01;
+
+    if (group->ble[2] == 3 || group->ble[3] == 3)
+        return 0;
+    if (rdsInfo.ptynAB != group->blockB.refined.textABFlag)
+    {
+        rdsInfo.ptynAB = group->blockB.refined.textABFlag;
+        memset(rdsInfo.ptyn, 0, sizeof(rdsInfo.ptyn));
+    }
+    rdsInfo.ptyn[address * 4] = group->blockC >> 8;
+    rdsInfo.ptyn[address * 4 + 1] = group->blockC & 0xFF;
+    rdsInfo.ptyn[address * 4 + 2] = group->blockD >> 8;
+    rdsInfo.ptyn[address * 4 + 3] = group->blockD & 0xFF;
+    return RDS_NEW_PTYN;
 }
 
 /**
- * @ingroup group13 Audio volume
+ * @ingroup group16 RDS status
  *
- * @brief Set sound volume level Down
+ * @brief Groups 14A and 14B: Enhanced Other Networks (PI of the other network on block D).
  *
- * @see setVolume()
+ * @details 14A variants 0 to 3 carry the PS of the other network and variant 13 its PTY and TA. 14B carries its TA.
  */
-void volumeDown()
+static uint16_t rdsDecode14(const si473x_rds_group *group)
 {
-    if (volume > 0)
-        volume--;
-    setVolume(volume);
+    si473x_rds_eon *on = NULL;
+    uint8_t variant = group->blockB.refined.content;
+
+    if (group->ble[3] == 3 || group->blockD == 0)
+        return 0;
+    for (uint8_t i = 0; i < SI473X_RDS_EON_SIZE && on == NULL; i++)
+        if (rdsInfo.eon[i].pi == group->blockD)
+            on = &rdsInfo.eon[i];
+    if (on == NULL)
+    { // New network: takes the oldest entry
+        on = &rdsInfo.eon[rdsInfo.eonNext];
+        rdsInfo.eonNext = (rdsInfo.eonNext + 1) % SI473X_RDS_EON_SIZE;
+        memset(on, 0, sizeof(*on));
+        on->pi = group->blockD;
+    }
+    on->tp = group->blockB.refined.textABFlag; // TP (ON)
+    if (group->blockB.refined.versionCode == 1)
+        on->ta = (variant >> 3) & 0x01;
+    else if (group->ble[2] < 3 && variant < 4)
+    {
+        on->ps[variant * 2] = group->blockC >> 8;
+        on->ps[variant * 2 + 1] = group->blockC & 0xFF;
+    }
+    else if (group->ble[2] < 3 && variant == 13)
+    {
+        on->pty = group->blockC >> 11;
+        on->ta = group->blockC & 0x01;
+    }
+    return RDS_NEW_EON;
 }
 
 /**
- * @defgroup group16 FM RDS/RBDS
- * @todo RDS Dynamic PS or Scrolling PS support
- */
-
-/*******************************************************************************
- * RDS implementation
- ******************************************************************************/
-
-/**
- * @ingroup group16 RDS setup
+ * @ingroup group16 RDS status
  *
- * @brief  Starts the control member variables for RDS.
+ * @brief Copies the group of currentRdsStatus to group.
  *
- * @details This method is called by setRdsConfig()
+ * @details A group is given once: polling an empty FIFO returns the last group again, and it must not be voted twice.
  *
- * @see setRdsConfig()
+ * @return false if no new group left the FIFO or its block B (group type) has uncorrectable errors
  */
-void RdsInit()
+static bool readRdsGroup(si473x_rds_group *group)
 {
-    clearRdsBuffer2A();
-    clearRdsBuffer2B();
-    clearRdsBuffer0A();
-    rdsTextAdress2A = rdsTextAdress2B = lastTextFlagAB = rdsTextAdress0A = 0;
+    if (!rdsGroupRemoved || currentRdsStatus.resp.BLEB == 3)
+        return false;
+    rdsGroupRemoved = false;
+
+    group->blockA = (uint16_t)currentRdsStatus.resp.BLOCKAH << 8 | currentRdsStatus.resp.BLOCKAL;
+    group->blockB.raw.highValue = currentRdsStatus.resp.BLOCKBH;
+    group->blockB.raw.lowValue = currentRdsStatus.resp.BLOCKBL;
+    group->blockC = (uint16_t)currentRdsStatus.resp.BLOCKCH << 8 | currentRdsStatus.resp.BLOCKCL;
+    group->blockD = (uint16_t)currentRdsStatus.resp.BLOCKDH << 8 | currentRdsStatus.resp.BLOCKDL;
+    group->ble[0] = currentRdsStatus.resp.BLEA;
+    group->ble[1] = currentRdsStatus.resp.BLEB;
+    group->ble[2] = currentRdsStatus.resp.BLEC;
+    group->ble[3] = currentRdsStatus.resp.BLED;
+    return true;
 }
 
 /**
- * @ingroup group16 RDS setup
+ * @ingroup group16 RDS status
  *
- * @brief Sets RDS property
+ * @brief Group handlers indexed by RDS_GROUP(type, version). NULL = group ignored.
+ */
+static si473x_rds_group_handler rdsGroupHandlers[32] = {
+    [RDS_GROUP(0, 0)] = rdsDecode0,
+    [RDS_GROUP(0, 1)] = rdsDecode0,
+    [RDS_GROUP(1, 0)] = rdsDecode1A,
+    [RDS_GROUP(2, 0)] = rdsDecode2,
+    [RDS_GROUP(2, 1)] = rdsDecode2,
+    [RDS_GROUP(3, 0)] = rdsDecode3A,
+    [RDS_GROUP(4, 0)] = rdsDecode4A,
+    [RDS_GROUP(10, 0)] = rdsDecode10A,
+    [RDS_GROUP(14, 0)] = rdsDecode14,
+    [RDS_GROUP(14, 1)] = rdsDecode14};
+
+/**
+ * @ingroup group16 RDS status
  *
- * @details Configures RDS settings to enable RDS processing (RDSEN) and set RDS block error thresholds.
- * @details When a RDS Group is received, all block errors must be less than or equal the associated block
- * error threshold for the group to be stored in the RDS FIFO.
- * @details IMPORTANT:
- * All block errors must be less than or equal the associated block error threshold
- * for the group to be stored in the RDS FIFO.
- * |Value | Description |
- * |------| ----------- |
- * | 0    | No errors |
- * | 1    | 1–2 bit errors detected and corrected |
- * | 2    | 3–5 bit errors detected and corrected |
- * | 3    | Uncorrectable |
+ * @brief Decodes the group of currentRdsStatus in a single pass.
  *
- * @details Recommended Block Error Threshold options:
- * | Exemples | Description |
- * | -------- | ----------- |
- * | 2,2,2,2  | No group stored if any errors are uncorrected |
- * | 3,3,3,3  | Group stored regardless of errors |
- * | 0,0,0,0  | No group stored containing corrected or uncorrected errors |
- * | 3,2,3,3  | Group stored with corrected errors on B, regardless of errors on A, C, or D |
+ * @details Block B is parsed once: PI, PTY and TP are stored on rdsInfo and the group goes to the handler of its
+ * @details type and version (0A/0B, 1A, 2A/2B, 3A, 4A, 10A and 14A/14B; see setRdsGroupHandler). Text goes to the
+ * @details same buffers used by getRdsText0A, getRdsText2A, getRdsText2B and getRdsTime; the other data goes to rdsInfo.
+ * @details Blocks with uncorrectable errors are not used; a new PI needs a block A without errors (or two that agree)
+ * @details and AF codes need a block C without errors. Call it after each getRdsStatus (drainRdsFifo does it).
+ * @code
+ * getRdsStatus();
+ * if (processRdsGroup() & RDS_NEW_PTYN)
+ *     showPtyn(rdsInfo.ptyn);
+ * @endcode
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 104
+ * @see drainRdsFifo, setRdsGroupHandler, setRdsOdaHandler, rdsInfo
  *
- * @param uint8_t RDSEN RDS Processing Enable; 1 = RDS processing enabled.
- * @param uint8_t BLETHA Block Error Threshold BLOCKA.
- * @param uint8_t BLETHB Block Error Threshold BLOCKB.
- * @param uint8_t BLETHC Block Error Threshold BLOCKC.
- * @param uint8_t BLETHD Block Error Threshold BLOCKD.
+ * @return RDS_NEW_* flags of the data changed by the group (0 = none)
  */
-void setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD)
+uint16_t processRdsGroup(void)
 {
-    si47x_property property;
-    si47x_rds_config config;
-
-    waitToSend();
-
-    // Set property value
-    property.value = FM_RDS_CONFIG;
-
-    // Arguments
-    config.arg.RDSEN = RDSEN;
-    config.arg.BLETHA = BLETHA;
-    config.arg.BLETHB = BLETHB;
-    config.arg.BLETHC = BLETHC;
-    config.arg.BLETHD = BLETHD;
-    config.arg.DUMMY1 = 0;
+    si473x_rds_group group;
+    si473x_rds_group_handler handler;
+    uint16_t updates = 0;
 
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, config.raw[1], config.raw[0]};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(1);
+    if (rdsAfCheck || !readRdsGroup(&group))
+        return 0;
 
-    RdsInit();
+    // A new PI is taken from a block A without errors or from two corrected blocks A that agree
+    if (group.ble[0] < 3 && group.blockA != rdsInfo.pi && (group.ble[0] == 0 || group.blockA == rdsPiCandidate))
+    {
+        if (rdsInfo.pi != 0) // Another program: the AF list belongs to the PI
+        {
+            rdsInfo.afCount = rdsInfo.afMethod = 0;
+            updates |= RDS_NEW_AF;
+        }
+        rdsInfo.pi = group.blockA;
+        updates |= RDS_NEW_PI;
+    }
+    rdsPiCandidate = (group.ble[0] < 3) ? group.blockA : 0;
+    if (!rdsCacheChecked && group.ble[0] == 0) // The PI is confirmed by a block A without errors
+    {
+        rdsCacheChecked = true;
+        updates |= recallRdsStation(group.blockA);
+    }
+    if (rdsInfo.pty != group.blockB.refined.programType || rdsInfo.tp != group.blockB.refined.trafficProgramCode)
+    {
+        rdsInfo.pty = group.blockB.refined.programType;
+        rdsInfo.tp = group.blockB.refined.trafficProgramCode;
+        updates |= RDS_NEW_FLAGS;
+    }
+    handler = rdsGroupHandlers[RDS_GROUP(group.blockB.refined.groupType, group.blockB.refined.versionCode)];
+    if (handler != NULL)
+        updates |= handler(&group);
+    return updates;
 }
 
 /**
- * @ingroup group16 RDS setup
+ * @ingroup group16 RDS status
  *
- * @brief Configures interrupt related to RDS
+ * @brief Sets the handler of a group type used by processRdsGroup.
  *
- * @details Use this method if want to use interrupt
+ * @details Use it to decode a group carried by an ODA (see setRdsOdaHandler) or to replace a built in handler.
+ * @details The handler gets the blocks and block errors of the group and returns the RDS_NEW_* flags it wants to report.
+ *
+ * @param group   RDS_GROUP(type, version); example: RDS_GROUP(8, 0) for 8A
+ * @param handler group handler (NULL = the group is ignored)
+ */
+void setRdsGroupHandler(uint8_t group, si473x_rds_group_handler handler)
+{
+    if (group < 32)
+        rdsGroupHandlers[group] = handler;
+}
+
+/**
+ * @ingroup group16 RDS status
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 103
+ * @brief Sets the function called by processRdsGroup for each Open Data Application announcement (group 3A).
  *
- * @param RDSRECV If set, generate RDSINT when RDS FIFO has at least FM_RDS_INT_FIFO_COUNT entries.
- * @param RDSSYNCLOST If set, generate RDSINT when RDS loses synchronization.
- * @param RDSSYNCFOUND set, generate RDSINT when RDS gains synchronization.
- * @param RDSNEWBLOCKA If set, generate an interrupt when Block A data is found or subsequently changed
- * @param RDSNEWBLOCKB If set, generate an interrupt when Block B data is found or subsequently changed
+ * @param handler receives the AID, the group used by the application (RDS_GROUP(type, version)) and the message bits
  */
-void setRdsIntSource(uint8_t RDSRECV, uint8_t RDSSYNCLOST, uint8_t RDSSYNCFOUND, uint8_t RDSNEWBLOCKA, uint8_t RDSNEWBLOCKB)
+void setRdsOdaHandler(void (*handler)(uint16_t aid, uint8_t group, uint16_t message))
 {
-    si47x_property property;
-    si47x_rds_int_source rds_int_source;
-
-    if (currentTune != FM_TUNE_FREQ)
-        return;
-
-    rds_int_source.refined.RDSNEWBLOCKB = RDSNEWBLOCKB;
-    rds_int_source.refined.RDSNEWBLOCKA = RDSNEWBLOCKA;
-    rds_int_source.refined.RDSSYNCFOUND = RDSSYNCFOUND;
-    rds_int_source.refined.RDSSYNCLOST = RDSSYNCLOST;
-    rds_int_source.refined.RDSRECV = RDSRECV;
-    rds_int_source.refined.DUMMY1 = 0;
-    rds_int_source.refined.DUMMY2 = 0;
-
-    property.value = FM_RDS_INT_SOURCE;
-
-    waitToSend();
-
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, rds_int_source.raw[1], rds_int_source.raw[0]};
-    SI4735_write(dat, sizeof(dat));
-    waitToSend();
+    rdsOdaHandler = handler;
 }
 
 /**
  * @ingroup group16 RDS status
  *
- * @brief Gets the RDS status. Store the status in currentRdsStatus member. RDS COMMAND FM_RDS_STATUS
+ * @brief Reads every group waiting on the RDS FIFO and decodes each of them (see processRdsGroup).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55 and 77
+ * @details getRdsStatus reads just one group per call. When FM_RDS_INT_FIFO_COUNT is greater than 1 (see setFifoCount)
+ * @details the groups pile up and the station name and text lag behind. This function reads the groups one after
+ * @details another (RDSFIFOUSED tells how many are left) and acknowledges RDSINT. It stops after SI473X_RDS_FIFO_SIZE groups.
+ * @details After it, currentRdsStatus holds the last group read.
+ * @code
+ * uint16_t updates;
+ * if (drainRdsFifo(&updates) && (updates & RDS_NEW_STATION_NAME))
+ *     showStationName(rds_buffer0A);
+ * @endcode
  *
- * @param INTACK Interrupt Acknowledge; 0 = RDSINT status preserved. 1 = Clears RDSINT.
- * @param MTFIFO 0 = If FIFO not empty, read and remove oldest FIFO entry; 1 = Clear RDS Receive FIFO.
- * @param STATUSONLY Determines if data should be removed from the RDS FIFO.
- *                   0 = Data in BLOCKA, BLOCKB, BLOCKC, BLOCKD, and BLE contain the oldest data in the RDS FIFO.
- *                   1 = Data in BLOCKA will contain the last valid block A data received for the cur- rent station. Data in BLOCKB will contain the last valid block B data received for the current station. Data in BLE will describe the bit errors for the data in BLOCKA and BLOCKB.
+ * @see getRdsAllData, setFifoCount, processRdsGroup
+ *
+ * @param updates if not NULL, receives the RDS_NEW_* flags of the data changed by the groups read
+ * @return number of groups read
  */
-void getRdsStatus_t(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY)
+uint8_t drainRdsFifo(uint16_t *updates)
 {
-    si47x_rds_command rds_cmd;
-    static uint16_t lastFreq;
-    // checking current FUNC (Am or FM)
-    if (currentTune != FM_TUNE_FREQ)
-        return;
+    uint8_t count = 0;
+    uint16_t changed = 0;
 
-    if (lastFreq != currentWorkFrequency)
+    while (currentTune == FM_TUNE_FREQ && !rdsAfCheck && count < SI473X_RDS_FIFO_SIZE) // The FIFO holds groups of an AF (see processAfSwitch)
     {
-        lastFreq = currentWorkFrequency;
-        clearRdsBuffer2A();
-        clearRdsBuffer2B();
-        clearRdsBuffer0A();
+        getRdsStatus_t(1, 0, 0);
+        if (currentRdsStatus.resp.RDSFIFOUSED == 0) // Nothing was removed from the FIFO
+            break;
+        currentRdsStatus.resp.RDSRECV = 1; // The group is valid even after RDSINT was acknowledged
+        changed |= processRdsGroup();
+        count++;
+        if (currentRdsStatus.resp.RDSFIFOUSED == 1) // It was the last one
+            break;
     }
-
-    waitToSend();
-
-    rds_cmd.arg.INTACK = INTACK;
-    rds_cmd.arg.MTFIFO = MTFIFO;
-    rds_cmd.arg.STATUSONLY = STATUSONLY;
-
-    uint8_t dat[] = {FM_RDS_STATUS, rds_cmd.raw};
-    SI4735_write(dat, sizeof(dat));
-
-   SI4735_read(currentRdsStatus.raw, 13);
-    HAL_Delay(1);
+    if (updates != NULL)
+        *updates = changed;
+    return count;
 }
 
 // See inlines methods / functions on SI4735.h
@@ -2206,34 +4658,20 @@ char *getRdsText(void)
  * @todo RDS Dynamic PS or Scrolling PS
  * @brief Gets the station name and other messages.
  *
- * @return char* should return a string with the station name.
+ * @details The group goes through the decoder of processRdsGroup: the characters are voted (see setRdsTextConfidence)
+ * @details and a segment with uncorrectable errors is not used.
+ *
+ * @return char* should return a string with the station name (NULL if the current group is not 0A/0B).
  *         However, some stations send other kind of messages
  */
 char *getRdsText0A(void)
 {
-    si47x_rds_blockb blkB;
+    si473x_rds_group group;
 
-    if (getRdsReceived())
+    if (getRdsGroupType() == 0 && readRdsGroup(&group))
     {
-        if (getRdsGroupType() == 0)
-        {
-            if (lastTextFlagAB != getRdsFlagAB())
-            {
-                lastTextFlagAB = getRdsFlagAB();
-                clearRdsBuffer0A();
-            }
-            // Process group type 0
-            blkB.raw.highValue = currentRdsStatus.resp.BLOCKBH;
-            blkB.raw.lowValue = currentRdsStatus.resp.BLOCKBL;
-
-            rdsTextAdress0A = blkB.group0.address;
-            if (rdsTextAdress0A >= 0 && rdsTextAdress0A < 4)
-            {
-                getNext2Block(&rds_buffer0A[rdsTextAdress0A * 2]);
-                rds_buffer0A[8] = '\0';
-                return rds_buffer0A;
-            }
-        }
+        rdsDecode0(&group);
+        return rds_buffer0A;
     }
     return NULL;
 }
@@ -2243,30 +4681,20 @@ char *getRdsText0A(void)
  *
  * @brief Gets the Text processed for the 2A group
  *
- * @return char* string with the Text of the group A2
+ * @details The group is assembled as done by processRdsGroup: rds_buffer2A only changes when a whole text
+ * @details was received (ended by 0x0D) or when the station starts a new one (A/B flag).
+ *
+ * @return char* string with the Text of the group A2 (NULL if the current group is not 2A)
+ * @see setRdsTextHandler
  */
 char *getRdsText2A(void)
 {
-    si47x_rds_blockb blkB;
+    si473x_rds_group group;
 
-    // getRdsStatus();
-    if (getRdsReceived())
+    if (getRdsGroupType() == 2 && getRdsVersionCode() == 0 && readRdsGroup(&group))
     {
-        if (getRdsGroupType() == 2 /* && getRdsVersionCode() == 0 */)
-        {
-            // Process group 2A
-            // Decode B block information
-            blkB.raw.highValue = currentRdsStatus.resp.BLOCKBH;
-            blkB.raw.lowValue = currentRdsStatus.resp.BLOCKBL;
-            rdsTextAdress2A = blkB.group2.address;
-
-            if (rdsTextAdress2A >= 0 && rdsTextAdress2A < 16)
-            {
-                getNext4Block(&rds_buffer2A[rdsTextAdress2A * 4]);
-                rds_buffer2A[63] = '\0';
-                return rds_buffer2A;
-            }
-        }
+        rdsDecode2(&group);
+        return rds_buffer2A;
     }
     return NULL;
 }
@@ -2276,32 +4704,19 @@ char *getRdsText2A(void)
  *
  * @brief Gets the Text processed for the 2B group
  *
- * @return char* string with the Text of the group AB
+ * @details Same as getRdsText2A for the 2B group (rds_buffer2B).
+ *
+ * @return char* string with the Text of the group AB (NULL if the current group is not 2B)
  */
 char *getRdsText2B(void)
 {
-    si47x_rds_blockb blkB;
+    si473x_rds_group group;
 
-    // getRdsStatus();
-    // if (getRdsReceived())
-    // {
-    // if (getRdsNewBlockB())
-    // {
-    if (getRdsGroupType() == 2 /* && getRdsVersionCode() == 1 */)
+    if (getRdsGroupType() == 2 && getRdsVersionCode() == 1 && readRdsGroup(&group))
     {
-        // Process group 2B
-        blkB.raw.highValue = currentRdsStatus.resp.BLOCKBH;
-        blkB.raw.lowValue = currentRdsStatus.resp.BLOCKBL;
-        rdsTextAdress2B = blkB.group2.address;
-        if (rdsTextAdress2B >= 0 && rdsTextAdress2B < 16)
-        {
-            getNext2Block(&rds_buffer2B[rdsTextAdress2B * 2]);
-            rds_buffer2B[32] = '\0';
-            return rds_buffer2B;
-        }
+        rdsDecode2(&group);
+        return rds_buffer2B;
     }
-    //  }
-    // }
     return NULL;
 }
 
@@ -2310,6 +4725,7 @@ char *getRdsText2B(void)
  * @brief Gets Station Name, Station Information, Program Information and utcTime
  * @details This function populates four char pointer variable parameters with Station Name, Station Information, Programa Information and UTC time.
  * @details You must call  setRDS(true), setRdsFifo(true) before calling getRdsAllData(...)
+ * @details It reads all groups waiting on the RDS FIFO (see drainRdsFifo). A parameter is not NULL when one of the groups changed it.
  * @details ATTENTION: You don't need to call any additional function to obtain the RDS information; simply follow the steps outlined below.
  * @details ATTENTION: If no data is found for the given parameter, it is assigned a NULL value. Prior to using the pointers variable, make sure to check if it is null.
  * @details the right way to call this function is shown below.
@@ -2381,17 +4797,253 @@ char *getRdsText2B(void)
  */
 bool getRdsAllData(char **stationName, char **stationInformation, char **programInformation, char **utcTime)
 {
-    rdsBeginQuery();
-    if (!getRdsReceived())
-        return false;
-    if (!getRdsSync() || getNumRdsFifoUsed() == 0)
+    uint16_t updates;
+
+    drainRdsFifo(&updates); // All groups waiting on the FIFO, not just the oldest one
+    *stationName = (updates & RDS_NEW_STATION_NAME) ? rds_buffer0A : NULL;
+    *stationInformation = (updates & RDS_NEW_STATION_INFO) ? rds_buffer2B : NULL;
+    *programInformation = (updates & RDS_NEW_PROGRAM_INFO) ? rds_buffer2A : NULL;
+    *utcTime = (updates & RDS_NEW_TIME) ? rds_time : NULL;
+
+    return updates != 0;
+}
+
+/**
+ * @ingroup group16 RDS
+ *
+ * @brief Starts following the station being listened to on its Alternative Frequencies (AF).
+ *
+ * @details Each call of processAfSwitch does one step. Every RDS_AF_CHECK_INTERVAL ms the signal of the station is
+ * @details checked (RSQ). When the RSSI or the SNR goes under minRssi or minSnr, the AFs of rdsInfo.af are visited:
+ * @details FAST tune, RSQ and, if the signal is better, the PI is listened to for RDS_AF_PI_WINDOW ms. The receiver
+ * @details stays on the first AF where two groups with a clean block A carry the same PI; otherwise it goes back
+ * @details to the station. The audio is muted while an AF is checked and the RDS data (PS, RT, AF list) is kept.
+ * @details After a check that finds no better AF, the next one waits twice as long (up to RDS_AF_MAX_BACKOFF doublings
+ * @details of RDS_AF_CHECK_INTERVAL), unless the signal of the station gets worse or the PI changes.
+ * @details While an AF is checked, STCINT is read at most every MIN_DELAY_STC_POLL us and the RDS status every RDS_AF_PI_POLL ms.
+ * @details The RDS must be enabled (setRdsConfig) and drainRdsFifo (or getRdsAllData) called from the main loop.
+ * @code
+ * si473x_af_switch af;
+ * startAfSwitch(&af, RDS_AF_MIN_RSSI, RDS_AF_MIN_SNR);
+ * for (;;)
+ * {
+ *     drainRdsFifo(&updates);
+ *     processAfSwitch(&af);
+ * }
+ * @endcode
+ *
+ * @see processAfSwitch, stopAfSwitch, rdsInfo
+ *
+ * @param af      AF switch state
+ * @param minRssi the AFs are checked when the RSSI (dBuV) of the station goes under it
+ * @param minSnr  the AFs are checked when the SNR (dB) of the station goes under it
+ */
+void startAfSwitch(si473x_af_switch *af, uint8_t minRssi, uint8_t minSnr)
+{
+    memset(af, 0, sizeof(*af));
+    if (currentTune != FM_TUNE_FREQ)
+        return;
+    af->minRssi = minRssi;
+    af->minSnr = minSnr;
+    af->lastCheck = transport->millis();
+    af->state = SI473X_AF_MONITOR;
+}
+
+/**
+ * @ingroup group16 RDS
+ *
+ * @brief Ends the check of the AFs: stays on frequency (AF with the right PI) or goes back to homeFrequency.
+ */
+static void endAfCheck(si473x_af_switch *af, uint16_t frequency)
+{
+    if (currentWorkFrequency != frequency)
+        setFrequency(frequency);
+    currentFrequencyParams.arg.FAST = af->savedFast;
+    rdsClearFifo(); // Groups of the last AF visited
+    if (frequency != af->homeFrequency)
+    {
+        rdsFrequency = frequency; // Same program: the RDS data is kept
+        addRdsAf((af->homeFrequency - 8750) / 10);
+        af->switches++;
+        af->failedSweeps = 0;
+    }
+    else if (af->failedSweeps < RDS_AF_MAX_BACKOFF)
+        af->failedSweeps++;
+    rdsAfCheck = false;
+    if (af->muted)
+        setAudioMute(false);
+    af->lastCheck = af->lastSweep = transport->millis();
+    af->state = SI473X_AF_MONITOR;
+}
+
+/**
+ * @ingroup group16 RDS
+ *
+ * @brief Does the next step of the AF switch. Call it from the main loop.
+ *
+ * @see startAfSwitch
+ *
+ * @param af AF switch state given to startAfSwitch
+ * @return false if the AF switch is not running
+ */
+bool processAfSwitch(si473x_af_switch *af)
+{
+    uint32_t now = transport->millis();
+
+    switch (af->state)
+    {
+    case SI473X_AF_MONITOR:
+        if ((now - af->lastCheck) < RDS_AF_CHECK_INTERVAL)
+            return true;
+        af->lastCheck = now;
+        getCurrentReceivedSignalQuality_t(0);
+        if (rdsInfo.pi == 0 || rdsInfo.afCount == 0 || (currentRqsStatus.resp.RSSI >= af->minRssi && currentRqsStatus.resp.SNR >= af->minSnr))
+            return true;
+        // The last checks found no better AF: back off (each one mutes the audio) while the station does not get worse
+        if (af->failedSweeps != 0 && rdsInfo.pi == af->pi && (uint16_t)currentRqsStatus.resp.RSSI + currentRqsStatus.resp.SNR >= af->homeScore &&
+            (now - af->lastSweep) < ((uint32_t)RDS_AF_CHECK_INTERVAL << af->failedSweeps))
+            return true;
+        if (rdsInfo.pi != af->pi)
+            af->failedSweeps = 0;
+        af->pi = rdsInfo.pi;
+        af->homeFrequency = currentWorkFrequency;
+        af->homeScore = (uint16_t)currentRqsStatus.resp.RSSI + currentRqsStatus.resp.SNR;
+        af->savedFast = currentFrequencyParams.arg.FAST;
+        af->muted = getCachedProperty(RX_HARD_MUTE) <= 0;
+        if (af->muted)
+            setAudioMute(true);
+        af->next = 0;
+        rdsAfCheck = true;
+        af->state = SI473X_AF_TUNE;
+        return true;
+    case SI473X_AF_TUNE:
+        if (af->next >= rdsInfo.afCount)
+        {
+            endAfCheck(af, af->homeFrequency);
+            return true;
+        }
+        af->frequency = 8750 + rdsInfo.af[af->next++] * 10;
+        if (af->frequency == af->homeFrequency || af->frequency < currentMinimumFrequency || af->frequency > currentMaximumFrequency)
+            return true;
+        currentFrequencyParams.arg.FAST = 1;
+        sendTuneFrequency(af->frequency);
+        af->stateStart = af->lastPoll = now;
+        af->state = SI473X_AF_WAIT_STC;
+        return true;
+    case SI473X_AF_WAIT_STC:
+        if (stcInterruptMode())
+        {
+            if (!stcInterruptFlag && (now - af->stateStart) < maxDelayTuneComplete)
+                return true;
+        }
+        else if ((now - af->lastPoll) * 1000UL < MIN_DELAY_STC_POLL)
+            return true; // Polling mode: GET_INT_STATUS at most every MIN_DELAY_STC_POLL us
+        af->lastPoll = now;
+        stcInterruptFlag = 0;
+        if (!isTuneComplete())
+        {
+            if ((now - af->stateStart) >= maxDelayTuneComplete)
+                af->state = SI473X_AF_TUNE;
+            return true;
+        }
+        getStatus(1, 0); // Clears STCINT
+        getCurrentReceivedSignalQuality_t(0);
+        if (currentRqsStatus.resp.RSSI < af->minRssi || currentRqsStatus.resp.SNR < af->minSnr ||
+            (uint16_t)currentRqsStatus.resp.RSSI + currentRqsStatus.resp.SNR <= af->homeScore)
+        {
+            af->state = SI473X_AF_TUNE;
+            return true;
+        }
+        rdsClearFifo(); // Groups received before the tune
+        af->piGroups = 0;
+        af->stateStart = af->lastPoll = now;
+        af->state = SI473X_AF_PI;
+        return true;
+    case SI473X_AF_PI:
+        // A group takes about 88 ms and the FIFO keeps them: there is no need to read the status on every call
+        if ((now - af->lastPoll) < RDS_AF_PI_POLL && (now - af->stateStart) < RDS_AF_PI_WINDOW)
+            return true;
+        af->lastPoll = now;
+        getRdsStatus_t(1, 0, 0);
+        // RDSRECV is latched: only a group that left the FIFO (RDSFIFOUSED) with a clean block A counts
+        if (currentRdsStatus.resp.RDSFIFOUSED != 0 && currentRdsStatus.resp.BLEA == 0)
+        {
+            if (((uint16_t)currentRdsStatus.resp.BLOCKAH << 8 | currentRdsStatus.resp.BLOCKAL) != af->pi)
+                af->state = SI473X_AF_TUNE; // Another program (regional variant or a different station)
+            else if (++af->piGroups == 2)
+                endAfCheck(af, af->frequency);
+        }
+        else if ((now - af->stateStart) >= RDS_AF_PI_WINDOW)
+            af->state = SI473X_AF_TUNE;
+        return true;
+    default:
         return false;
-    *stationName = getRdsText0A();        // returns NULL if no information
-    *stationInformation = getRdsText2B(); // returns NULL if no information
-    *programInformation = getRdsText2A(); // returns NULL if no information
-    *utcTime = getRdsTime();              // returns NULL if no information
+    }
+}
+
+/**
+ * @ingroup group16 RDS
+ *
+ * @brief Stops the AF switch. If an AF was being checked, the station is tuned again.
+ *
+ * @param af AF switch state given to startAfSwitch
+ */
+void stopAfSwitch(si473x_af_switch *af)
+{
+    if (af->state != SI473X_AF_MONITOR && af->state != SI473X_AF_IDLE)
+        endAfCheck(af, af->homeFrequency);
+    af->state = SI473X_AF_IDLE;
+}
+
+/**
+ * @ingroup group16 RDS Time and Date
+ *
+ * @brief Writes the UTC time and offset of a 4A group on rds_time (see getRdsTime).
+ *
+ * @return rds_time or NULL if the time is not valid
+ */
+static char *decodeRdsTime(uint16_t blockB, uint16_t blockC, uint16_t blockD)
+{
+    si47x_rds_date_time dt;
+    char offset_sign;
+    int offset_h;
+    int offset_m;
+    uint16_t minute;
+    uint16_t hour;
 
-    return (bool)stationName | (bool)stationInformation | (bool)programInformation | (bool)utcTime;
+    dt.raw[4] = blockB & 0xFF;
+    dt.raw[5] = blockB >> 8;
+    dt.raw[2] = blockC & 0xFF;
+    dt.raw[3] = blockC >> 8;
+    dt.raw[0] = blockD & 0xFF;
+    dt.raw[1] = blockD >> 8;
+
+    // Unfortunately it was necessary dues to  the GCC compiler on 32-bit platform.
+    // See si47x_rds_date_time (typedef union) and CGG “Crosses boundary” issue/features.
+    // Now it is working on Atmega328, STM32, Arduino DUE, ESP32 and more.
+    minute = dt.refined.minute;
+    hour = dt.refined.hour;
+
+    offset_sign = (dt.refined.offset_sense == 1) ? '+' : '-';
+    offset_h = (dt.refined.offset * 30) / 60;
+    offset_m = (dt.refined.offset * 30) - (offset_h * 60);
+
+    // Using convertToChar instead sprintf to save space (about 1.2K on ATmega328 compiler tools).
+
+    if (offset_h > 12 || offset_m > 60 || hour > 24 || minute > 60)
+        return NULL;
+
+    convertToChar(hour, rds_time, 2, 0, ' ', false);
+    rds_time[2] = ':';
+    convertToChar(minute, &rds_time[3], 2, 0, ' ', false);
+    rds_time[5] = ' ';
+    rds_time[6] = offset_sign;
+    convertToChar(offset_h, &rds_time[7], 2, 0, ' ', false);
+    rds_time[9] = ':';
+    convertToChar(offset_m, &rds_time[10], 2, 0, ' ', false);
+    rds_time[12] = '\0';
+
+    return rds_time;
 }
 
 /**
@@ -2407,58 +5059,10 @@ bool getRdsAllData(char **stationName, char **stationInformation, char **program
  */
 char *getRdsTime()
 {
-    // Under Test and construction
-    // Need to check the Group Type before.
-    si47x_rds_date_time dt;
-
-    uint16_t minute;
-    uint16_t hour;
-
     if (getRdsGroupType() == 4)
-    {
-        char offset_sign;
-        int offset_h;
-        int offset_m;
-
-        // uint16_t y, m, d;
-
-        dt.raw[4] = currentRdsStatus.resp.BLOCKBL;
-        dt.raw[5] = currentRdsStatus.resp.BLOCKBH;
-        dt.raw[2] = currentRdsStatus.resp.BLOCKCL;
-        dt.raw[3] = currentRdsStatus.resp.BLOCKCH;
-        dt.raw[0] = currentRdsStatus.resp.BLOCKDL;
-        dt.raw[1] = currentRdsStatus.resp.BLOCKDH;
-
-        // Unfortunately it was necessary dues to  the GCC compiler on 32-bit platform.
-        // See si47x_rds_date_time (typedef union) and CGG “Crosses boundary” issue/features.
-        // Now it is working on Atmega328, STM32, Arduino DUE, ESP32 and more.
-        minute = dt.refined.minute;
-        hour = dt.refined.hour;
-
-        offset_sign = (dt.refined.offset_sense == 1) ? '+' : '-';
-        offset_h = (dt.refined.offset * 30) / 60;
-        offset_m = (dt.refined.offset * 30) - (offset_h * 60);
-        // sprintf(rds_time, "%02u:%02u %c%02u:%02u", dt.refined.hour, dt.refined.minute, offset_sign, offset_h, offset_m);
-        // sprintf(rds_time, "%02u:%02u %c%02u:%02u", hour, minute, offset_sign, offset_h, offset_m);
-
-        // Using convertToChar instead sprintf to save space (about 1.2K on ATmega328 compiler tools).
-
-        if (offset_h > 12 || offset_m > 60 || hour > 24 || minute > 60)
-            return NULL;
-
-        convertToChar(hour, rds_time, 2, 0, ' ', false);
-        rds_time[2] = ':';
-        convertToChar(minute, &rds_time[3], 2, 0, ' ', false);
-        rds_time[5] = ' ';
-        rds_time[6] = offset_sign;
-        convertToChar(offset_h, &rds_time[7], 2, 0, ' ', false);
-        rds_time[9] = ':';
-        convertToChar(offset_m, &rds_time[10], 2, 0, ' ', false);
-        rds_time[12] = '\0';
-
-        return rds_time;
-    }
-
+        return decodeRdsTime((uint16_t)currentRdsStatus.resp.BLOCKBH << 8 | currentRdsStatus.resp.BLOCKBL,
+                             (uint16_t)currentRdsStatus.resp.BLOCKCH << 8 | currentRdsStatus.resp.BLOCKCL,
+                             (uint16_t)currentRdsStatus.resp.BLOCKDH << 8 | currentRdsStatus.resp.BLOCKDL);
     return NULL;
 }
 
@@ -2716,15 +5320,10 @@ void setSSBBfo(int offset)
     if (currentTune == FM_TUNE_FREQ) // Only for AM/SSB mode
         return;
 
-    waitToSend();
-
     property.value = SSB_BFO;
     bfo_offset.value = offset;
 
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, bfo_offset.raw.FREQH, bfo_offset.raw.FREQL};
-    SI4735_write(dat, sizeof(dat));
-		
-    HAL_Delay(1);
+    sendProperty(property.value, bfo_offset.value);
 }
 
 /**
@@ -2900,7 +5499,9 @@ void setSSB(uint8_t usblsb)
     setPowerUp(ctsIntEnable, 0, 0, currentClockType, 1, currentAudioMode);
     radioPowerUp();
     // ssbPowerUp(); // Not used for regular operation
+    beginProperties();
     setVolume(volume); // Set to previus configured volume
+    commitProperties();
     currentSsbStatus = usblsb;
     lastMode = SSB_CURRENT_MODE;
 }
@@ -2949,10 +5550,7 @@ void sendSSBModeProperty()
 {
     si47x_property property;
     property.value = SSB_MODE;
-    waitToSend();
-    uint8_t dat[] = {SET_PROPERTY, 0, property.raw.byteHigh, property.raw.byteLow, currentSSBMode.raw[1], currentSSBMode.raw[0]};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(1);
+    sendProperty(property.value, (currentSSBMode.raw[1] << 8) | currentSSBMode.raw[0]);
 }
 
 /**
@@ -3024,73 +5622,208 @@ void setSsbAgcOverrite(uint8_t SSBAGCDIS, uint8_t SSBAGCNDX, uint8_t reserved)
  * @details When applying the patch, the PATCH bit in ARG1 of the POWER_UP command must be
  * set to 1 to begin the patching process. [AN332 (REV 1.0) page 219].
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 64 and 215-220.
- * @see struct si47x_firmware_query_library
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 64 and 215-220.
+ * @see struct si47x_firmware_query_library
+ *
+ * @return a struct si47x_firmware_query_library (see it in SI4735.h)
+ */
+si47x_firmware_query_library queryLibraryId()
+{
+    si47x_firmware_query_library libraryID;
+
+    powerDown(); // Is it necessary
+
+    // transport->delayMs(500);
+
+    waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES); // POWER_UP restores the default values
+    uint8_t dat[] = {POWER_UP, 0x1f, SI473X_ANALOG_AUDIO};
+    SI4735_write(dat, sizeof(dat));
+
+    do
+    {
+        waitToSend();
+        SI4735_read(libraryID.raw, 8);
+    } while (libraryID.resp.ERR); // If error found, try it again.
+
+    transport->delayMs(3);
+
+    return libraryID;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief This method can be used to prepare the device to apply SSBRX patch
+ *
+ * @details Call queryLibraryId before call this method. Powerup the device by issuing the POWER_UP
+ * command with FUNC = 1 (AM/SW/LW Receive).
+ *
+ * @see setMaxDelaySetFrequency()
+ * @see MAX_DELAY_AFTER_POWERUP
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 64 and 215-220 and
+ * @see AN332 REV 0.8 UNIVERSAL PROGRAMMING GUIDE AMENDMENT FOR SI4735-D60 SSB AND NBFM PATCHES; page 7.
+ */
+void patchPowerUp()
+{
+    waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES); // POWER_UP restores the default values
+    residentPatch = NULL;                            // A new patch is coming
+    uint8_t dat[] = {POWER_UP, 0x31, SI473X_ANALOG_AUDIO};
+    SI4735_write(dat, sizeof(dat));
+    transport->delayMs(maxDelayAfterPouwerUp);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief This function can be useful for debug and test.
+ */
+void ssbPowerUp()
+{
+    waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES); // POWER_UP restores the default values
+
+    powerUp.arg.CTSIEN = ctsIntEnable;     // 1 -> Interrupt anabled;
+    powerUp.arg.GPO2OEN = 0;               // 1 -> GPO2 Output Enable;
+    powerUp.arg.PATCH = 0;                 // 0 -> Boot normally;
+    powerUp.arg.XOSCEN = currentClockType; // 1 -> Use external crystal oscillator;
+    powerUp.arg.FUNC = 1;                  // 0 = FM Receive; 1 = AM/SSB (LW/MW/SW) Receiver.
+    powerUp.arg.OPMODE = currentAudioMode; // Analog and/or digital audio outputs (see setup)
+
+    uint8_t dat[] = {POWER_UP, powerUp.raw[0], powerUp.raw[1]};
+    SI4735_write(dat, sizeof(dat));
+    transport->delayMs(3);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Clears patchResult at the start of a patch download.
+ */
+static void startPatchResult(void)
+{
+    patchResult.status = PATCH_RESULT_OK;
+    patchResult.line = -1;
+    patchResult.patchId = 0;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Sends one 8 bytes patch line (0x15 or 0x16 command) to the device.
+ *
+ * @details The line is written only when the device shows CTS (waitToSend): the first line follows POWER_UP, which may
+ * @details still be running. On PATCH_DOWNLOAD_CTS mode the CTS of the previous line was already read, so it costs nothing.
+ * @details On PATCH_DOWNLOAD_CTS mode, the status byte is polled every minDelayPatchPoll us until CTS (see waitPatchLine).
+ * @details The SI4735 issues a status after each 8 byte transfered. Just the bit 7 (CTS) should be set.
+ * @details If ERR is set, or CTS does not come within MAX_DELAY_PATCH_LINE ms, the line is rejected.
+ * @details On PATCH_DOWNLOAD_DELAY mode, it just waits 1 ms (legacy behavior).
+ *
+ * @param line  8 bytes line
+ * @param index line number (stored in patchResult if the device rejects it)
+ * @return false if the device rejected the line
+ */
+static bool sendPatchLine(const uint8_t *line, uint16_t index)
+{
+    waitToSend();
+    SI4735_write((uint8_t *)line, 8);
+    return waitPatchLine(index);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Waits for the device to process the patch line just written (see sendPatchLine).
  *
- * @return a struct si47x_firmware_query_library (see it in SI4735.h)
+ * @param index line number (stored in patchResult if the device rejects it)
+ * @return false if the device rejected the line
  */
-si47x_firmware_query_library queryLibraryId()
+static bool waitPatchLine(uint16_t index)
 {
-    si47x_firmware_query_library libraryID;
-
-    powerDown(); // Is it necessary
-
-    // HAL_Delay(500);
+    uint8_t cmd_status;
+    uint32_t start;
 
-    waitToSend();
-    uint8_t dat[] = {POWER_UP, 0x1f, SI473X_ANALOG_AUDIO};
-    SI4735_write(dat, sizeof(dat));
+    if (patchDownloadMode == PATCH_DOWNLOAD_DELAY)
+    {
+        transport->delayMs(1); // Need check the minimum value
+        return true;
+    }
 
+    start = transport->millis();
     do
     {
-        waitToSend();
-        SI4735_read(libraryID.raw, 8);
-    } while (libraryID.resp.ERR); // If error found, try it again.
-
-    HAL_Delay(3);
+        transport->delayUs(minDelayPatchPoll);
+        SI4735_read(&cmd_status, 1);
+    } while (!(cmd_status & 0B10000000) && (transport->millis() - start) < MAX_DELAY_PATCH_LINE);
 
-    return libraryID;
+    if (cmd_status != 0x80)
+    {
+        patchResult.status = PATCH_RESULT_CHIP_ERR;
+        patchResult.line = index;
+        return false;
+    }
+    ctsReady = 1;
+    return true;
 }
 
 /**
  * @ingroup group17 Patch and SSB support
  *
- * @brief This method can be used to prepare the device to apply SSBRX patch
+ * @brief Records the patch ID declared by a patch line.
  *
- * @details Call queryLibraryId before call this method. Powerup the device by issuing the POWER_UP
- * command with FUNC = 1 (AM/SW/LW Receive).
+ * @details The last line of the SSB patches (0x15 00 00 00 00 00 IDH IDL) declares the ID reported by GET_REV.
  *
- * @see setMaxDelaySetFrequency()
- * @see MAX_DELAY_AFTER_POWERUP
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 64 and 215-220 and
- * @see AN332 REV 0.8 UNIVERSAL PROGRAMMING GUIDE AMENDMENT FOR SI4735-D60 SSB AND NBFM PATCHES; page 7.
+ * @param line  8 bytes line
  */
-void patchPowerUp()
+static void checkPatchIdLine(const uint8_t *line)
 {
-    waitToSend();
-    uint8_t dat[] = {POWER_UP, 0x31, SI473X_ANALOG_AUDIO};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(maxDelayAfterPouwerUp);
+    if (line[0] == 0x15 && !line[1] && !line[2] && !line[3] && !line[4] && !line[5])
+        patchResult.patchId = (uint16_t)(line[6] << 8 | line[7]);
 }
 
 /**
  * @ingroup group17 Patch and SSB support
  *
- * @brief This function can be useful for debug and test.
+ * @brief Powers the device up on the patch it already holds, if any.
+ *
+ * @details When patch is the last one downloaded, the device was not reset or powered up on FM since then and it
+ * @details keeps its patch through POWER_DOWN (see setPatchRetention), the device is powered up (AM, PATCH = 0, the
+ * @details current clock and interrupt setup) and GET_REV must report the patch ID. It costs the power up time instead
+ * @details of a full download. Without retention nothing is sent: the probe would always fail.
+ *
+ * @param patch  patch content that will be loaded
+ * @return true if the device runs the patch; false if it has to be downloaded
  */
-void ssbPowerUp()
+static bool resumeResidentPatch(const uint8_t *patch)
 {
-    waitToSend();
-    uint8_t dat[] = {POWER_UP, 0x11, 5};
-    SI4735_write(dat, sizeof(dat));
-    HAL_Delay(3);
+    if (!patchRetention || patch == NULL || patch != residentPatch)
+        return false;
 
-    powerUp.arg.CTSIEN = ctsIntEnable;     // 1 -> Interrupt anabled;
-    powerUp.arg.GPO2OEN = 0;               // 1 -> GPO2 Output Enable;
-    powerUp.arg.PATCH = 0;                 // 0 -> Boot normally;
-    powerUp.arg.XOSCEN = currentClockType; // 1 -> Use external crystal oscillator;
-    powerUp.arg.FUNC = 1;                  // 0 = FM Receive; 1 = AM/SSB (LW/MW/SW) Receiver.
-    powerUp.arg.OPMODE = 0b00000101;       // 0x5 = 00000101 = Analog audio outputs (LOUT/ROUT).
+    powerDown();
+    setPowerUp(ctsIntEnable, 0, 0, currentClockType, AM_CURRENT_MODE, currentAudioMode);
+    radioPowerUp();
+    getFirmware();
+    if (((uint16_t)firmwareInfo.resp.PATCHH << 8 | firmwareInfo.resp.PATCHL) == residentPatchId)
+        return true;
+
+    residentPatch = NULL;
+    return false;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Records the patch just downloaded (see resumeResidentPatch).
+ *
+ * @param patch       patch content
+ * @param downloaded  result of the download
+ */
+static void setResidentPatch(const uint8_t *patch, bool downloaded)
+{
+    // A patch without ID cannot be checked with GET_REV
+    residentPatch = (downloaded && patchResult.patchId != 0) ? patch : NULL;
+    residentPatchId = patchResult.patchId;
 }
 
 /**
@@ -3131,50 +5864,43 @@ void ssbPowerUp()
  *  @param ssb_patch_content point to array of bytes content patch.
  *  @param ssb_patch_content_size array size (number of bytes). The maximum size allowed for a patch is 15856 bytes
  *
- *  @return false if an error is found.
+ *  @return false if the device rejected a line (see getPatchErrorLine).
  */
 bool downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size)
 {
-    uint8_t content;
+    uint16_t line = 0;
+
+    startPatchResult();
     // Send patch to the SI4735 device
     for (uint16_t offset = 0; offset < ssb_patch_content_size; offset += 8)
     {
-    	SI4735_write((uint8_t *)(ssb_patch_content + offset), 8);
-
-
-        // Testing download performance
-        // approach 1 - Faster - less secure (it might crash in some architectures)
-        HAL_Delay(1); // Need check the minimum value
-
-        // approach 2 - More control. A little more secure than approach 1
-        /*
-        do
-        {
-            delayM7icroseconds(150); // Minimum delay founded (Need check the minimum value)
-            SI473X_requestFrom(deviceAddress, 1);
-        } while (!(SI473X_read() & B10000000));
-        */
-
-        // approach 3 - same approach 2
-        // waitToSend();
-
-        // approach 4 - safer
-        /*
-        waitToSend();
-        uint8_t cmd_status;
-        // Uncomment the lines below if you want to check erro.
-        SI473X_requestFrom(deviceAddress, 1);
-        cmd_status = SI473X_read();
-        // The SI4735 issues a status after each 8 byte transfered.
-        // Just the bit 7 (CTS) should be seted. if bit 6 (ERR) is seted, the system halts.
-        if (cmd_status != 0x80)
-           return false;
-        */
-    }
-    HAL_Delay(1);
+        if (!sendPatchLine(ssb_patch_content + offset, line++))
+            return false;
+        checkPatchIdLine(ssb_patch_content + offset);
+    }
+    if (patchDownloadMode == PATCH_DOWNLOAD_DELAY)
+        transport->delayMs(1);
     return true;
 }
 
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Gets the first byte (0x15 or 0x16) of a line of a compressed patch.
+ *
+ * @param cmd_0x15  lines (ascending order) that begin with 0x15
+ * @param count     lines in cmd_0x15
+ * @param line      line number; the calls must be in ascending order of line
+ * @param next      cursor on cmd_0x15 (0 before the first line)
+ * @return uint8_t  0x15 or 0x16
+ */
+static uint8_t compressedLineCommand(const uint16_t *cmd_0x15, uint16_t count, uint16_t line, uint16_t *next)
+{
+    while (*next < count && cmd_0x15[*next] < line)
+        (*next)++;
+    return (*next < count && cmd_0x15[*next] == line) ? 0x15 : 0x16;
+}
+
 /**
  * @ingroup group17 Patch and SSB support
  *
@@ -3186,6 +5912,8 @@ bool downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_co
  * @details is omitted and a new array is added to indicate which lines begin with the value 0x15.
  * @details For the other lines, the downloadCompressedPatch method will insert the value 0x16.
  * @details The value 0x16 occurs on most lines in the patch. This approach will save about 1K of memory.
+ * @details The cmd_0x15 array must be in ascending order: it is walked with a cursor, so each line costs O(1).
+ * @details tools/patch_compress.py builds the compressed arrays from patch_init.h or patch_full.h.
  * @details The example code below shows how to use compressed SSB patch.
  * @code
  *   #include <patch_ssb_compressed.h> // SSB patch for whole SSBRX initialization string
@@ -3213,39 +5941,33 @@ bool downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_co
  * @see  SI47XX_09_NOKIA_5110/ALL_IN_ONE_7_BUTTONS/ALL_IN_ONE_7_BUTTONS.ino
  * @param ssb_patch_content         point to array of bytes content patch.
  * @param ssb_patch_content_size    array size (number of bytes). The maximum size allowed for a patch is 15856 bytes
- * @param cmd_0x15                  Array of lines where the first byte of each patch content line is 0x15
+ * @param cmd_0x15                  Array of lines (ascending order) where the first byte of each patch content line is 0x15
  * @param cmd_0x15_size             Array size
+ * @return false if the device rejected a line (see getPatchErrorLine).
  */
 bool downloadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size)
 {
-    uint8_t cmd, content;
     uint16_t command_line = 0;
+    uint16_t next_0x15 = 0; // Cursor on cmd_0x15: the array is in ascending order
+    const uint16_t count_0x15 = cmd_0x15_size / sizeof(uint16_t);
+
+    startPatchResult();
     // Send patch to the SI4735 device
     for (uint16_t offset = 0; offset < ssb_patch_content_size; offset += 7)
     {
-        // Checks if the current line starts with 0x15
-        cmd = 0x16;
-        for (uint16_t i = 0; i < cmd_0x15_size / sizeof(uint16_t); i++)
-        {
-            if (cmd_0x15[i]== command_line)
-            { // it needs performance improvement: save the last "i" value to be used next time
-                cmd = 0x15;
-                break;
-            }
-        }
-				
-				uint8_t dat[8];
-				dat[0] = cmd;
+        uint8_t dat[8];
+        dat[0] = compressedLineCommand(cmd_0x15, count_0x15, command_line, &next_0x15);
         for (uint16_t i = 0; i < 7; i++)
         {
             dat[i+1] = ssb_patch_content[i + offset];
         }
-				SI4735_write(dat, sizeof(dat));
-
-        HAL_Delay(1); // Need check the minimum value
+        if (!sendPatchLine(dat, command_line))
+            return false;
+        checkPatchIdLine(dat);
         command_line++;
     }
-    HAL_Delay(1);
+    if (patchDownloadMode == PATCH_DOWNLOAD_DELAY)
+        transport->delayMs(1);
     return true;
 }
 
@@ -3253,6 +5975,8 @@ bool downloadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ss
  * @ingroup group17 Patch and SSB support
  * @brief Loads a given SSB patch content
  * @details Configures the Si4735-D60/SI4732-A10 device to work with SSB.
+ * @details If the device still holds this patch (no reset or FM power up since it was loaded), it is just powered up
+ * @details on it and the download is skipped (see clearResidentPatch).
  *
  * @param ssb_patch_content        point to patch content array
  * @param ssb_patch_content_size   size of patch content
@@ -3260,10 +5984,13 @@ bool downloadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ss
  */
 void loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint8_t ssb_audiobw)
 {
-    queryLibraryId();
-    patchPowerUp();
-    HAL_Delay(50);
-    downloadPatch(ssb_patch_content, ssb_patch_content_size);
+    if (!resumeResidentPatch(ssb_patch_content))
+    {
+        queryLibraryId();
+        patchPowerUp();
+        transport->delayMs(50);
+        setResidentPatch(ssb_patch_content, downloadPatch(ssb_patch_content, ssb_patch_content_size));
+    }
     // Parameters
     // AUDIOBW - SSB Audio bandwidth; 0 = 1.2kHz (default); 1=2.2kHz; 2=3kHz; 3=4kHz; 4=500Hz; 5=1kHz;
     // SBCUTFLT SSB - side band cutoff filter for band passand low pass filter ( 0 or 1)
@@ -3272,13 +5999,14 @@ void loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_conten
     // SMUTESEL - SSB Soft-mute Based on RSSI or SNR (0 or 1).
     // DSP_AFCDIS - DSP AFC Disable or enable; 0=SYNC MODE, AFC enable; 1=SSB MODE, AFC disable.
     setSSBConfig(ssb_audiobw, 1, 0, 0, 0, 1);
-    HAL_Delay(25);
+    transport->delayMs(25);
 }
 
 /**
  * @ingroup group17 Patch and SSB support
  * @brief Loads the SSB compressed patch content
  * @details Configures the Si4735-D60/SI4732-A10 device to work with SSB.
+ * @details The download is skipped if the device still holds this patch (see loadPatch).
  *
  * @param ssb_patch_content        point to patch content array
  * @param ssb_patch_content_size   size of patch content
@@ -3288,10 +6016,13 @@ void loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_conten
  */
 void loadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size, uint8_t ssb_audiobw)
 {
-    queryLibraryId();
-    patchPowerUp();
-    HAL_Delay(50);
-    downloadCompressedPatch(ssb_patch_content, ssb_patch_content_size, cmd_0x15, cmd_0x15_size);
+    if (!resumeResidentPatch(ssb_patch_content))
+    {
+        queryLibraryId();
+        patchPowerUp();
+        transport->delayMs(50);
+        setResidentPatch(ssb_patch_content, downloadCompressedPatch(ssb_patch_content, ssb_patch_content_size, cmd_0x15, cmd_0x15_size));
+    }
     // Parameters
     // AUDIOBW - SSB Audio bandwidth; 0 = 1.2kHz (default); 1=2.2kHz; 2=3kHz; 3=4kHz; 4=500Hz; 5=1kHz;
     // SBCUTFLT SSB - side band cutoff filter for band passand low pass filter ( 0 or 1)
@@ -3300,7 +6031,390 @@ void loadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_pa
     // SMUTESEL - SSB Soft-mute Based on RSSI or SNR (0 or 1).
     // DSP_AFCDIS - DSP AFC Disable or enable; 0=SYNC MODE, AFC enable; 1=SSB MODE, AFC disable.
     setSSBConfig(ssb_audiobw, 1, 0, 0, 0, 1);
-    HAL_Delay(25);
+    transport->delayMs(25);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief State of the LZ patch decoder (see downloadLzPatch).
+ */
+typedef struct
+{
+    const uint8_t *patch; // LZ container
+    uint16_t size;        // Container size
+    uint16_t gapPos;      // Next gap of the 0x15 line list
+    uint16_t left0x15;    // Gaps not read yet
+    uint16_t next0x15;    // Next line that begins with 0x15 (0xFFFF = none)
+    uint16_t lineNumber;  // Line being rebuilt
+    uint8_t line[8];      // Line being rebuilt (0x15/0x16 + 7 bytes)
+    uint8_t lineFill;     // Bytes already in line
+    uint8_t window[256];  // Last bytes decoded (a match reaches back up to 255 bytes)
+    uint8_t windowPos;    // Where the next byte goes in the window (wraps at 256)
+} si473x_lz_decoder;
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Reads a number stored 7 bits per byte (least significant first; bit 7 = more bytes follow).
+ *
+ * @param patch  LZ container
+ * @param size   container size
+ * @param pos    where the number starts; returns where the next field starts
+ * @param value  the number
+ * @return false if the number goes beyond the container or does not fit 16 bits
+ */
+static bool lzReadNumber(const uint8_t *patch, uint16_t size, uint16_t *pos, uint16_t *value)
+{
+    uint32_t result = 0;
+
+    for (uint8_t shift = 0; shift < 21; shift += 7)
+    {
+        if (*pos >= size)
+            return false;
+        uint8_t b = patch[(*pos)++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            *value = (uint16_t)result;
+            return result <= 0xFFFF;
+        }
+    }
+    return false;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Adds a decoded byte to the current line and sends the line to the device when it has 8 bytes.
+ *
+ * @param d  decoder
+ * @param b  decoded byte
+ * @return false if the device rejected the line or the 0x15 line list is corrupted
+ */
+static bool lzPutByte(si473x_lz_decoder *d, uint8_t b)
+{
+    uint16_t gap;
+
+    d->window[d->windowPos++] = b;
+    if (d->lineFill == 0)
+    {
+        d->line[0] = 0x16;
+        if (d->lineNumber == d->next0x15)
+        {
+            d->line[0] = 0x15;
+            d->next0x15 = 0xFFFF;
+            if (d->left0x15)
+            {
+                d->left0x15--;
+                if (!lzReadNumber(d->patch, d->size, &d->gapPos, &gap) || gap == 0)
+                {
+                    patchResult.line = d->lineNumber;
+                    return false;
+                }
+                d->next0x15 = d->lineNumber + gap;
+            }
+        }
+        d->lineFill = 1;
+    }
+    d->line[d->lineFill++] = b;
+    if (d->lineFill == 8)
+    {
+        d->lineFill = 0;
+        if (!sendPatchLine(d->line, d->lineNumber))
+            return false;
+        checkPatchIdLine(d->line);
+        d->lineNumber++;
+    }
+    return true;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Transfers a LZ compressed patch to the SI4735 device.
+ *
+ * @details The patch is decoded while it is sent: each 8 bytes line is rebuilt and written to the device at once,
+ * @details so just a 256 bytes window is needed (the patch is never stored in RAM).
+ * @details Build the LZ container with tools/patch_lz.py from patch_init.h or patch_full.h. The container holds the
+ * @details list of lines that begin with 0x15 (the other lines begin with 0x16) and LZ sequences of the other 7 bytes
+ * @details of each line. The SSB patch is almost random data, so most of the saving comes from the 0x15/0x16 bytes and from
+ * @details the runs of zeros: patch_init.h goes from 8840 to 7636 bytes (7845 bytes on the compressed format).
+ *
+ * @see tools/patch_lz.py, loadLzPatch, downloadCompressedPatch
+ *
+ * @param patch       LZ container
+ * @param patch_size  container size (number of bytes)
+ * @return false if the container is not valid or the device rejected a line (see getPatchErrorLine).
+ */
+bool downloadLzPatch(const uint8_t *patch, const uint16_t patch_size)
+{
+    si473x_lz_decoder d;
+    uint16_t pos = 5, lines, left, n, gap;
+    uint32_t decoded = 0;
+
+    startPatchResult();
+    patchResult.status = PATCH_RESULT_FORMAT_ERR; // Until the container is decoded
+    if (patch_size < 5 || patch[0] != SI473X_LZ_PATCH_VERSION)
+        return false;
+
+    lines = patch[1] | patch[2] << 8;
+    d.patch = patch;
+    d.size = patch_size;
+    d.left0x15 = patch[3] | patch[4] << 8;
+    d.next0x15 = 0xFFFF;
+    d.lineNumber = 0;
+    d.lineFill = 0;
+    d.windowPos = 0;
+
+    // The first gap is the number of the first 0x15 line. The LZ sequences start after the last gap.
+    for (left = d.left0x15; left > 0; left--)
+        if (!lzReadNumber(patch, patch_size, &pos, &gap))
+            return false;
+    d.gapPos = 5;
+    if (d.left0x15)
+    {
+        d.left0x15--;
+        lzReadNumber(patch, patch_size, &d.gapPos, &d.next0x15);
+    }
+
+    while (d.lineNumber < lines)
+    {
+        if (pos >= patch_size)
+            break;
+        uint8_t token = patch[pos++];
+
+        // Literals
+        n = token >> 4;
+        if (n == 15 && !lzReadNumber(patch, patch_size, &pos, &left))
+            break;
+        if (n == 15)
+            n += left;
+        if ((uint32_t)pos + n > patch_size || decoded + n > (uint32_t)lines * 7)
+            break;
+        for (; n > 0; n--, decoded++)
+            if (!lzPutByte(&d, patch[pos++]))
+                return false;
+        if (d.lineNumber >= lines)
+            break;
+
+        // Match: copies n bytes from offset bytes back
+        if (pos >= patch_size)
+            break;
+        uint8_t offset = patch[pos++];
+        n = token & 0x0F;
+        if (n == 15 && !lzReadNumber(patch, patch_size, &pos, &left))
+            break;
+        if (n == 15)
+            n += left;
+        n += SI473X_LZ_MIN_MATCH;
+        if (offset == 0 || offset > decoded || decoded + n > (uint32_t)lines * 7)
+            break;
+        for (; n > 0; n--, decoded++)
+            if (!lzPutByte(&d, d.window[(uint8_t)(d.windowPos - offset)]))
+                return false;
+    }
+    if (d.lineNumber < lines)
+    { // Corrupted container: the device has received part of the patch
+        patchResult.line = d.lineNumber;
+        return false;
+    }
+    patchResult.status = PATCH_RESULT_OK;
+    if (patchDownloadMode == PATCH_DOWNLOAD_DELAY)
+        transport->delayMs(1);
+    return true;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Loads a LZ compressed SSB patch (see downloadLzPatch)
+ * @details Configures the Si4735-D60/SI4732-A10 device to work with SSB.
+ * @details The download is skipped if the device still holds this patch (see loadPatch).
+ *
+ * @param patch        LZ container built by tools/patch_lz.py
+ * @param patch_size   container size
+ * @param ssb_audiobw  SSB Audio bandwidth; 0 = 1.2kHz (default); 1=2.2kHz; 2=3kHz; 3=4kHz; 4=500Hz; 5=1kHz.
+ */
+void loadLzPatch(const uint8_t *patch, const uint16_t patch_size, uint8_t ssb_audiobw)
+{
+    if (!resumeResidentPatch(patch))
+    {
+        queryLibraryId();
+        patchPowerUp();
+        transport->delayMs(50);
+        setResidentPatch(patch, downloadLzPatch(patch, patch_size));
+    }
+    setSSBConfig(ssb_audiobw, 1, 0, 0, 0, 1);
+    transport->delayMs(25);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Adds bytes to a CRC-16/CCITT-FALSE (see patchCrc16).
+ *
+ * @param crc   CRC of the previous bytes (0xFFFF at the start)
+ * @param data  bytes
+ * @param size  number of bytes
+ * @return uint16_t CRC
+ */
+static uint16_t updatePatchCrc16(uint16_t crc, const uint8_t *data, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Computes the CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of a patch array.
+ *
+ * @details tools/patch_crc.py and tools/patch_lz.py compute the same CRC on the PC (SSB_PATCH_CRC, SSB_PATCH_LZ_CRC).
+ *
+ * @param data  patch array
+ * @param size  array size (number of bytes)
+ * @return uint16_t CRC
+ */
+uint16_t patchCrc16(const uint8_t *data, uint16_t size)
+{
+    return updatePatchCrc16(0xFFFF, data, size);
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Checks the patch ID reported by the device (GET_REV) against the ID declared by the patch just downloaded.
+ *
+ * @details Patches without the ID line (0x15 00 00 00 00 00 IDH IDL) are not checked.
+ */
+static void checkPatchId(void)
+{
+    if (patchResult.status != PATCH_RESULT_OK || patchResult.patchId == 0)
+        return;
+    getFirmware();
+    if (((uint16_t)firmwareInfo.resp.PATCHH << 8 | firmwareInfo.resp.PATCHL) != patchResult.patchId)
+        patchResult.status = PATCH_RESULT_ID_MISMATCH;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Transfers a patch to the device after checking its CRC, and checks the patch ID at the end.
+ *
+ * @details Nothing is sent if the CRC of the array does not match (PATCH_RESULT_CRC_MISMATCH). Each line is checked
+ * @details by the device status (PATCH_RESULT_CHIP_ERR and the line number). At the end, GET_REV must report the ID
+ * @details declared by the last 0x15 line of the patch (PATCH_RESULT_ID_MISMATCH).
+ * @code
+ *   #include "patch_full.h"
+ *   queryLibraryId();
+ *   patchPowerUp();
+ *   si473x_patch_result r = downloadPatchChecked(ssb_patch_content, sizeof ssb_patch_content, SSB_PATCH_CRC);
+ *   if (r.status == PATCH_RESULT_CHIP_ERR)
+ *       printf("line %d rejected\n", r.line);
+ * @endcode
+ *
+ * @see downloadPatch, patchCrc16, tools/patch_crc.py
+ *
+ * @param ssb_patch_content       patch array (patch_init.h or patch_full.h format)
+ * @param ssb_patch_content_size  array size (number of bytes)
+ * @param crc                     expected CRC (SSB_PATCH_CRC)
+ * @return si473x_patch_result    also stored in patchResult
+ */
+si473x_patch_result downloadPatchChecked(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint16_t crc)
+{
+    if (patchCrc16(ssb_patch_content, ssb_patch_content_size) != crc)
+    {
+        startPatchResult();
+        patchResult.status = PATCH_RESULT_CRC_MISMATCH;
+        return patchResult;
+    }
+    if (downloadPatch(ssb_patch_content, ssb_patch_content_size))
+        checkPatchId();
+    return patchResult;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Transfers a compressed patch to the device after checking its CRC, and checks the patch ID at the end.
+ *
+ * @details Works like downloadPatchChecked. The CRC is the one of the original patch (SSB_PATCH_CRC of patch_init.h or
+ * @details patch_full.h): the lines are rebuilt from both arrays, so a wrong cmd_0x15 array is detected too.
+ *
+ * @see downloadCompressedPatch, downloadPatchChecked, tools/patch_crc.py
+ *
+ * @param ssb_patch_content       compressed patch array (patch_ssb_compressed.h format)
+ * @param ssb_patch_content_size  array size (number of bytes)
+ * @param cmd_0x15                array of lines (ascending order) that begin with 0x15
+ * @param cmd_0x15_size           cmd_0x15 size (number of bytes)
+ * @param crc                     expected CRC of the original patch (SSB_PATCH_CRC)
+ * @return si473x_patch_result    also stored in patchResult
+ */
+si473x_patch_result downloadCompressedPatchChecked(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size, uint16_t crc)
+{
+    uint16_t sum = 0xFFFF, line = 0, next_0x15 = 0;
+    const uint16_t count_0x15 = cmd_0x15_size / sizeof(uint16_t);
+
+    for (uint16_t offset = 0; offset < ssb_patch_content_size; offset += 7, line++)
+    {
+        uint8_t cmd = compressedLineCommand(cmd_0x15, count_0x15, line, &next_0x15);
+        sum = updatePatchCrc16(sum, &cmd, 1);
+        sum = updatePatchCrc16(sum, &ssb_patch_content[offset], 7);
+    }
+    if (sum != crc)
+    {
+        startPatchResult();
+        patchResult.status = PATCH_RESULT_CRC_MISMATCH;
+        return patchResult;
+    }
+    if (downloadCompressedPatch(ssb_patch_content, ssb_patch_content_size, cmd_0x15, cmd_0x15_size))
+        checkPatchId();
+    return patchResult;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Transfers a LZ compressed patch to the device after checking its CRC, and checks the patch ID at the end.
+ *
+ * @details Works like downloadPatchChecked. A container that cannot be decoded gives PATCH_RESULT_FORMAT_ERR.
+ *
+ * @see downloadLzPatch, downloadPatchChecked, tools/patch_lz.py
+ *
+ * @param patch       LZ container
+ * @param patch_size  container size (number of bytes)
+ * @param crc         expected CRC (SSB_PATCH_LZ_CRC)
+ * @return si473x_patch_result also stored in patchResult
+ */
+si473x_patch_result downloadLzPatchChecked(const uint8_t *patch, const uint16_t patch_size, uint16_t crc)
+{
+    if (patchCrc16(patch, patch_size) != crc)
+    {
+        startPatchResult();
+        patchResult.status = PATCH_RESULT_CRC_MISMATCH;
+        return patchResult;
+    }
+    if (downloadLzPatch(patch, patch_size))
+        checkPatchId();
+    return patchResult;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Reads bytes from a 24Cxx EEPROM (2 bytes address) with one sequential read.
+ *
+ * @param eeprom_i2c_address  I2C address of the EEPROM
+ * @param address             first EEPROM address
+ * @param data                where the bytes will be stored
+ * @param len                 number of bytes
+ */
+static void eepromRead(uint16_t eeprom_i2c_address, uint16_t address, uint8_t *data, size_t len)
+{
+    uint8_t dat[] = {address >> 8, address & 0xFF};
+    transport->write(dat, sizeof(dat), eeprom_i2c_address);
+    transport->read(data, len, eeprom_i2c_address);
 }
 
 /**
@@ -3308,62 +6422,68 @@ void loadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_pa
  * @brief Transfers the content of a patch stored in an eeprom to the SI4735 device.
  * @details To used this method, you will need an eeprom with the patch content stored into it.
  * @details This content have to be generated by the sketch [SI47XX_09_SAVE_SSB_PATCH_EEPROM](https://github.com/pu2clr/SI4735/tree/master/examples/TOOLS/SI47XX_09_SAVE_SSB_PATCH_EEPROM) on folder TOOLS.
+ * @details The header is read and checked once. The patch is read in SI473X_EEPROM_CHUNK bytes sequential reads on two
+ * @details buffers: the next chunk is read while the device processes the last line of the current one.
+ * @details The throughput (bytes per second) is stored in eepromPatchThroughput.
  *
  * @see SI47XX_09_SAVE_SSB_PATCH_EEPROM
  * @see si4735_eeprom_patch_header
  * @ref https://github.com/pu2clr/SI4735/tree/master/examples/TOOLS/SI47XX_09_SAVE_SSB_PATCH_EEPROM
  *
  * @param eeprom_i2c_address
- * @return false if an error is found.
+ * @return the header of the patch; patch_id is "error!" if the header is not valid or the device rejected a line (see getPatchErrorLine).
  */
 si4735_eeprom_patch_header downloadPatchFromEeprom(int eeprom_i2c_address)
 {
     si4735_eeprom_patch_header eep;
-    const int header_size = sizeof eep;
-    uint8_t bufferAux[8];
-    int offset, i;
+    uint8_t buffer[2][SI473X_EEPROM_CHUNK];
+    uint8_t current = 0;
+    uint16_t size, done = 0, len, next_len, line = 0;
+    uint32_t start = transport->millis(), elapsed;
 
-    // Gets the EEPROM patch header information
-     // Gets the EEPROM patch header information
-    uint8_t dat[] = {0,0};
-    SI4735_write_to(dat, sizeof(dat), eeprom_i2c_address);
-
-    HAL_Delay(5);
+    startPatchResult();
 
-    // The first two bytes of the header will be ignored.
-    for (int k = 0; k < header_size; k += 8) {
-        i = k * 8;
-        SI4735_read_from(&eep.raw[i], 8, eeprom_i2c_address);
+    // Gets the EEPROM patch header information
+    eepromRead(eeprom_i2c_address, 0, eep.raw, sizeof(eep));
+    size = eep.refined.patch_size;
+    if (size == 0 || (size % 8) != 0 || size > SI473X_MAX_PATCH_SIZE)
+    {
+        patchResult.status = PATCH_RESULT_FORMAT_ERR;
+        strcpy((char *)eep.refined.patch_id, "error!");
+        return eep;
     }
 
-
     // Transferring patch from EEPROM to SI4735 device
-    offset = header_size;
-    for (i = 0; i < (int)eep.refined.patch_size; i += 8) {
-        // Reads patch content from EEPROM
-        uint8_t dat[] = {offset >> 8, offset & 0xFF};
-        SI4735_write_to(dat, sizeof(dat), eeprom_i2c_address);
-
-        SI4735_read_from(bufferAux, 8, eeprom_i2c_address);
-
-        SI4735_write(bufferAux, 8);
-
-        waitToSend();
-
-        uint8_t cmd_status;
-        // The SI4735 issues a status after each 8 byte transfered.Just the bit 7(CTS)should be seted.if bit 6(ERR)is seted, the system halts.
-        SI4735_read(&cmd_status, 1);
-				
-        // The SI4735 issues a status after each 8 byte transfered.Just the bit 7(CTS)should be seted.if bit 6(ERR)is seted, the system halts.
-        if (cmd_status != 0x80)
+    len = (size < SI473X_EEPROM_CHUNK) ? size : SI473X_EEPROM_CHUNK;
+    eepromRead(eeprom_i2c_address, sizeof(eep), buffer[current], len);
+    while (len > 0)
+    {
+        next_len = ((size - done - len) < SI473X_EEPROM_CHUNK) ? (size - done - len) : SI473X_EEPROM_CHUNK;
+        for (uint16_t i = 0; i < len; i += 8)
         {
-            strcpy((char *)eep.refined.patch_id, "error!");
-            return eep;
+            waitToSend(); // The first line follows POWER_UP
+            SI4735_write(&buffer[current][i], 8);
+            // The device processes the last line of the chunk while the next chunk is read
+            if (i + 8 == len && next_len > 0)
+                eepromRead(eeprom_i2c_address, sizeof(eep) + done + len, buffer[current ^ 1], next_len);
+            if (!waitPatchLine(line))
+            {
+                strcpy((char *)eep.refined.patch_id, "error!");
+                return eep;
+            }
+            checkPatchIdLine(&buffer[current][i]);
+            line++;
         }
-        offset += 8; // Start processing the next 8 bytes
+        done += len;
+        len = next_len;
+        current ^= 1;
     }
 
-    HAL_Delay(50);
+    elapsed = transport->millis() - start;
+    eepromPatchThroughput = (uint32_t)size * 1000 / (elapsed ? elapsed : 1);
+
+    if (patchDownloadMode == PATCH_DOWNLOAD_DELAY)
+        transport->delayMs(50);
     return eep;
 }
 
@@ -3496,10 +6616,12 @@ void removeUnwantedChar(char *str, int size)
 void patchPowerUpNBFM()
 {
     waitToSend();
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES); // POWER_UP restores the default values
+    residentPatch = NULL;                            // A new patch is coming
     uint8_t dat[] = {POWER_UP, 0x30, SI473X_ANALOG_AUDIO};
     SI4735_write(dat, sizeof(dat));
 
-    HAL_Delay(maxDelayAfterPouwerUp);
+    transport->delayMs(maxDelayAfterPouwerUp);
 }
 
 /**
@@ -3514,10 +6636,10 @@ void loadPatchNBFM(const uint8_t *patch_content, const uint16_t patch_content_si
 {
     queryLibraryId();
     patchPowerUpNBFM();
-    HAL_Delay(50);
+    transport->delayMs(50);
     downloadPatch(patch_content, patch_content_size);
     // TODO
-    HAL_Delay(25);
+    transport->delayMs(25);
 }
 
 /**
@@ -3585,6 +6707,8 @@ void setNBFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t
  *
  * @brief Set the frequency to the corrent function of the Si4735 on NBFM mode
  * @details You have to call setup or setPowerUp before call setFrequency.
+ * @details setFrequency returned void in earlier versions; it now returns whether the tune completed. Callers that
+ * @details ignore the result keep working as before.
  *
  * @see maxDelaySetFrequency()
  * @see MAX_DELAY_AFTER_SET_FREQUENCY
@@ -3595,15 +6719,13 @@ void setNBFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t
  */
 void setFrequencyNBFM(uint16_t freq)
 {
-    waitToSend(); // Wait for the si473x is ready.
     currentFrequency.value = freq;
     currentFrequencyParams.arg.FREQH = currentFrequency.raw.FREQH;
     currentFrequencyParams.arg.FREQL = currentFrequency.raw.FREQL;
 
-    uint8_t dat[] = {0x50, 0, currentFrequency.raw.FREQH, currentFrequency.raw.FREQL};
-    SI4735_write(dat, sizeof(dat));
-		
-    waitToSend();                // Wait for the si473x is ready.
+    uint8_t args[] = {0, currentFrequency.raw.FREQH, currentFrequency.raw.FREQL};
+    stcInterruptFlag = 0;
+    runCommand(NBFM_TUNE_FREQ, sizeof(args), args, 0, NULL);
     currentWorkFrequency = freq; // check it
-    HAL_Delay(250);              // For some reason I need to delay here.
+    waitTuneComplete();
 }
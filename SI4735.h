@@ -2,9 +2,13 @@
 #define _SI4735_H
 
 #include "SI4735_HAL.h"
+#ifndef SI473X_HOST
 #include "main.h"
+#endif
 #include <stdlib.h>
-#include "patch_init.h" // SSB patch for whole SSBRX initialization string
+#ifdef SI473X_HOST
+#include <stdio.h>
+#endif
 
 #define POWER_UP_FM 0  // FM
 #define POWER_UP_AM 1  // AM and SSB (if patch applyed)
@@ -185,13 +189,87 @@
 #define MAX_DELAY_AFTER_SET_FREQUENCY 30 // In ms - This value helps to improve the precision during of getting frequency value
 #define MAX_DELAY_AFTER_POWERUP 10       // In ms - Max delay you have to setup after a power up command.
 #define MIN_DELAY_WAIT_SEND_LOOP 300     // In uS (Microsecond) - each loop of waitToSend sould wait this value in microsecond
+#define MAX_DELAY_CTS_INTERRUPT 10       // In ms - max time waitToSend waits for the CTS interrupt before falling back to polling
+#define MAX_DELAY_TUNE_COMPLETE 300      // In ms - max time waitTuneComplete waits for STCINT (tune or seek complete)
+#define MIN_DELAY_STC_POLL 1000          // In us - GET_INT_STATUS polling step of waitTuneComplete
 #define MAX_SEEK_TIME 8000               // defines the maximum seeking time 8s is default.
+#define MIN_DELAY_PATCH_POLL 20          // In us - CTS polling step after each patch line (PATCH_DOWNLOAD_CTS)
+#define MAX_DELAY_PATCH_LINE 10          // In ms - max time the device can take to accept a patch line
+#define SCAN_MIN_RSSI 20                 // In dBuV - default min RSSI of a station found by scanBand
+#define SCAN_MIN_SNR 3                   // In dB - default min SNR of a station found by scanBand
+#define SCAN_RDS_WINDOW 2500             // In ms - default time processBackgroundScan listens to the RDS of a station (voted PS)
 
 #define DEFAULT_CURRENT_AVC_AM_MAX_GAIN 36
 
 #define XOSCEN_CRYSTAL 1 // Use crystal oscillator
 #define XOSCEN_RCLK 0    // Use external RCLK (crystal oscillator disabled).
 
+#define SI473X_MAX_PATCH_SIZE 15856 // Largest patch accepted by the device (bytes)
+#define SI473X_EEPROM_CHUNK 64       // Bytes read from the EEPROM at once by downloadPatchFromEeprom (multiple of 8)
+
+#define SI473X_LZ_PATCH_VERSION 1 // Format of the LZ patch container (see downloadLzPatch and tools/patch_lz.py)
+#define SI473X_LZ_MIN_MATCH 3     // Shortest LZ match of the container
+
+#define PATCH_RESULT_OK 0           // Patch downloaded and checked
+#define PATCH_RESULT_CRC_MISMATCH 1 // The patch array does not match its CRC (nothing was sent)
+#define PATCH_RESULT_CHIP_ERR 2     // The device rejected a line (see si473x_patch_result.line)
+#define PATCH_RESULT_ID_MISMATCH 3  // GET_REV does not report the ID declared by the patch
+#define PATCH_RESULT_FORMAT_ERR 4   // The patch container or EEPROM header is not valid
+
+#define PATCH_DOWNLOAD_DELAY 0 // Waits 1 ms after each patch line (legacy)
+#define PATCH_DOWNLOAD_CTS 1   // Polls CTS and checks ERR after each patch line
+
+#define CTS_WAIT_POLLING 0   // waitToSend polls the status byte over I2C
+#define CTS_WAIT_INTERRUPT 1 // waitToSend waits for the GPO2/INT CTS interrupt (falls back to polling)
+
+#define SI473X_CMD_MAX_ARGS 7         // Largest argument list sent by this library (patch lines)
+#define SI473X_CMD_QUEUE_SIZE 8       // Number of commands the command engine can hold
+#define MAX_DELAY_COMMAND_TIMEOUT 500 // In ms - a queued command not completed in this time is dropped with ERR set
+
+#define SI473X_PROPERTY_CACHE_SIZE 32 // Properties kept by the shadow table
+#define SI473X_ALL_PROPERTIES 0xFFFF  // Used by invalidateCachedProperty
+#define SI473X_PROPERTY_BATCH_SIZE 16 // Properties stored by beginProperties/addProperty
+
+#define SI473X_RDS_FIFO_SIZE 25 // Groups held by the RDS FIFO of the device (most groups read by one drainRdsFifo)
+#define SI473X_RDS_AF_SIZE 25   // Alternative Frequencies kept by rdsInfo
+#define SI473X_RDS_EON_SIZE 4   // Other networks (EON) kept by rdsInfo
+#define RDS_TEXT_CONFIDENCE 4   // Votes a PS/RT character needs to be shown (see setRdsTextConfidence)
+#define SI473X_RDS_CACHE_SIZE 8 // Stations kept by the RDS station cache (see setRdsCache)
+
+#define RDS_AF_METHOD_A 1         // rdsInfo.afMethod: one list with all AFs of the station
+#define RDS_AF_METHOD_B 2         // rdsInfo.afMethod: one list per transmitter (only the one of the tuned frequency is kept)
+#define RDS_AF_MIN_RSSI 25        // In dBuV - default RSSI under which startAfSwitch looks for a better AF
+#define RDS_AF_MIN_SNR 10         // In dB - default SNR under which startAfSwitch looks for a better AF
+#define RDS_AF_CHECK_INTERVAL 2000 // In ms - time between two signal checks of processAfSwitch
+#define RDS_AF_PI_WINDOW 500      // In ms - time processAfSwitch listens to the PI of an AF (two groups after the RDS sync)
+#define RDS_AF_PI_POLL 20         // In ms - FM_RDS_STATUS polling step of processAfSwitch while it listens to the PI of an AF
+#define RDS_AF_MAX_BACKOFF 4      // Doublings of RDS_AF_CHECK_INTERVAL between AF checks that find no better AF (up to 32 s)
+
+#define SI473X_RDS_CAPTURE_SIZE 64 // Groups kept by a capture ring buffer (power of two; see startRdsCapture)
+#define SI473X_RDS_GROUP_LINE 38   // Characters of a line written by formatRdsGroup (with '\n' and '\0')
+
+#define SI473X_AF_IDLE 0     // startAfSwitch was not called (or stopAfSwitch was)
+#define SI473X_AF_MONITOR 1  // Checking the signal of the station
+#define SI473X_AF_TUNE 2     // The next AF will be tuned
+#define SI473X_AF_WAIT_STC 3 // Waiting for the end of the tune
+#define SI473X_AF_PI 4       // Listening to the PI of the AF
+
+// RDS data changed by processRdsGroup and drainRdsFifo
+#define RDS_NEW_STATION_NAME 0x0001 // rds_buffer0A (groups 0A and 0B)
+#define RDS_NEW_PROGRAM_INFO 0x0002 // rds_buffer2A: a new Radio Text was published (group 2A)
+#define RDS_NEW_STATION_INFO 0x0004 // rds_buffer2B: a new Radio Text was published (group 2B)
+#define RDS_NEW_TIME 0x0008         // rds_time (group 4A)
+#define RDS_NEW_PI 0x0010           // rdsInfo.pi
+#define RDS_NEW_FLAGS 0x0020        // rdsInfo.pty, tp, ta, ms or di
+#define RDS_NEW_AF 0x0040           // rdsInfo.af (group 0A)
+#define RDS_NEW_PIN 0x0080          // rdsInfo.pin or rdsInfo.ecc (group 1A)
+#define RDS_NEW_PTYN 0x0100         // rdsInfo.ptyn (group 10A)
+#define RDS_NEW_EON 0x0200          // rdsInfo.eon (groups 14A and 14B)
+#define RDS_NEW_ODA 0x0400          // An ODA was announced (group 3A; see setRdsOdaHandler)
+#define RDS_NEW_CACHED 0x0800       // The data of the station was recalled from the station cache (see setRdsCache)
+
+#define RDS_GROUP(type, version) ((type) << 1 | (version)) // Index used by setRdsGroupHandler (RDS_GROUP(2, 0) = 2A)
+
 /** @defgroup group01 Union, Struct and Defined Data Types
  * @section group01 Data Types
  *
@@ -1030,6 +1108,387 @@ typedef struct
     uint16_t DOSR;                   // Digital Output Sample Rate(32–48 ksps .0 to disable digital audio output).
 } si4735_digital_output_sample_rate; // Maybe not necessary
 
+/**
+ * @ingroup group01
+ *
+ * @brief Command descriptor used by the non-blocking command engine.
+ *
+ * @details Holds everything the engine needs to run a command without blocking the caller:
+ * the command, its arguments, where to store the response and who to call when it is done.
+ * The arguments are copied into the queue. The response buffer must stay valid until the command completes.
+ *
+ * @see queueCommand, processCommandQueue
+ */
+typedef struct
+{
+    uint8_t cmd;                       //!< Command (see AN332)
+    uint8_t argc;                      //!< Number of arguments (up to SI473X_CMD_MAX_ARGS)
+    uint8_t args[SI473X_CMD_MAX_ARGS]; //!< Arguments (ARG1, ARG2, ...)
+    uint8_t responseSize;              //!< Number of response bytes to read (status byte included). 0 = just wait for CTS.
+    uint8_t *response;                 //!< Where the response is stored (can be NULL if responseSize is 0)
+    void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response); //!< Called when the command completes (can be NULL)
+} si473x_command;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Entry of the property shadow table (last value written to the device)
+ */
+typedef struct
+{
+    uint16_t property; //!< Property number
+    uint16_t value;    //!< Last value written
+    bool used;         //!< false = free entry (invalidated; taken by the next new property)
+} si473x_property_cache;
+
+/**
+ * @ingroup group17
+ *
+ * @brief Result of a patch download (see downloadPatchChecked)
+ */
+typedef struct
+{
+    uint8_t status;   //!< PATCH_RESULT_OK, PATCH_RESULT_CRC_MISMATCH, PATCH_RESULT_CHIP_ERR, PATCH_RESULT_ID_MISMATCH or PATCH_RESULT_FORMAT_ERR
+    int16_t line;     //!< Line where the download stopped (-1 = none)
+    uint16_t patchId; //!< Patch ID declared by the last 0x15 line sent (0 = none)
+} si473x_patch_result;
+
+/**
+ * @ingroup group16
+ *
+ * @brief RDS group given to the group handlers (see processRdsGroup)
+ */
+typedef struct
+{
+    uint16_t blockA;         //!< PI
+    si47x_rds_blockb blockB; //!< Group type, version, TP, PTY and the group specific bits
+    uint16_t blockC;
+    uint16_t blockD;
+    uint8_t ble[4]; //!< Block errors of blocks A to D (0 = none; 1 = 1-2 bits corrected; 2 = 3-5 bits corrected; 3 = uncorrectable)
+} si473x_rds_group;
+
+/**
+ * @ingroup group16
+ *
+ * @brief Group handler: decodes a group and returns the RDS_NEW_* flags of the data it changed
+ */
+typedef uint16_t (*si473x_rds_group_handler)(const si473x_rds_group *group);
+
+/**
+ * @ingroup group16
+ *
+ * @brief Other network announced by EON (groups 14A and 14B)
+ */
+typedef struct
+{
+    uint16_t pi; //!< PI of the other network (0 = free entry)
+    char ps[9];  //!< Program Service name of the other network
+    uint8_t pty; //!< Program Type of the other network
+    uint8_t tp;  //!< Traffic Program of the other network
+    uint8_t ta;  //!< Traffic Announcement of the other network
+} si473x_rds_eon;
+
+/**
+ * @ingroup group16
+ *
+ * @brief RDS data decoded by processRdsGroup (besides the text buffers)
+ */
+typedef struct
+{
+    uint16_t pi;                             //!< Program Identification (0 = not received)
+    uint8_t pty;                             //!< Program Type
+    uint8_t tp;                              //!< Traffic Program
+    uint8_t ta;                              //!< Traffic Announcement (0A/0B)
+    uint8_t ms;                              //!< 1 = Music; 0 = Speech (0A/0B)
+    uint8_t di;                              //!< Decoder Identification d3 to d0 (0A/0B; one bit per PS segment)
+    uint8_t ecc;                             //!< Extended Country Code (1A variant 0; 0 = not received)
+    uint16_t pin;                            //!< Program Item Number: day (5 bits), hour (5 bits), minute (6 bits)
+    uint8_t af[SI473X_RDS_AF_SIZE];          //!< Alternative Frequency codes (frequency = 8750 + code * 10)
+    uint8_t afCount;                         //!< Codes stored on af
+    uint8_t afMethod;                        //!< RDS_AF_METHOD_A, RDS_AF_METHOD_B or 0 (not known yet)
+    char ptyn[9];                            //!< Program Type Name (10A)
+    uint8_t ptynAB;                          //!< A/B flag of the ptyn being received
+    si473x_rds_eon eon[SI473X_RDS_EON_SIZE]; //!< Other networks (14A/14B)
+    uint8_t eonNext;                         //!< Entry replaced when eon is full
+} si473x_rds_info;
+
+/**
+ * @ingroup group16
+ *
+ * @brief Character votes of a text being received (rds_buffer0A or rdsRtWork)
+ *
+ * @details Each reception of a character adds the weight of its block error level to the score when it
+ * @details matches the candidate and subtracts it otherwise. The character is copied to the text buffer
+ * @details when the score reaches rdsTextConfidence.
+ */
+typedef struct
+{
+    char candidate[64]; //!< Character being voted at each position
+    uint8_t score[64];  //!< Votes of candidate
+    uint16_t confirmed; //!< Segments whose characters reached rdsTextConfidence (bit n = segment n)
+} si473x_rds_text_vote;
+
+/**
+ * @ingroup group16
+ *
+ * @brief RDS data of a station kept by the station cache (see setRdsCache)
+ */
+typedef struct
+{
+    uint16_t pi;                    //!< Program Identification (0 = free entry)
+    uint16_t frequency;             //!< Frequency where the data was received
+    uint8_t pty;                    //!< Program Type
+    char ps[9];                     //!< Program Service name
+    char rt[65];                    //!< Last Radio Text published
+    uint8_t rtVersion;              //!< 0 = rt came from 2A; 1 = from 2B
+    uint8_t af[SI473X_RDS_AF_SIZE]; //!< Alternative Frequency codes
+    uint8_t afCount;                //!< Codes stored on af
+    uint16_t lastUsed;              //!< Stored or recalled at this use of the cache (LRU)
+} si473x_rds_station;
+
+/**
+ * @ingroup group16
+ *
+ * @brief State of the AF switch (see startAfSwitch)
+ */
+typedef struct
+{
+    uint8_t state;          //!< SI473X_AF_IDLE, _MONITOR, _TUNE, _WAIT_STC or _PI
+    uint8_t minRssi;        //!< The AFs are checked when the RSSI of the station goes under it
+    uint8_t minSnr;         //!< The AFs are checked when the SNR of the station goes under it
+    uint8_t next;           //!< Index on rdsInfo.af of the next AF to check
+    uint16_t pi;            //!< PI of the station being followed
+    uint16_t homeFrequency; //!< Frequency of the station when the check started
+    uint16_t homeScore;     //!< RSSI + SNR of homeFrequency when the check started
+    uint16_t frequency;     //!< AF being checked
+    uint8_t piGroups;       //!< Groups with the PI of the station received on the AF being checked
+    uint32_t stateStart;    //!< When (ms) the current state started
+    uint32_t lastCheck;     //!< When (ms) the signal of the station was checked
+    uint32_t lastPoll;      //!< When (ms) the device was last polled (WAIT_STC and PI states)
+    uint32_t lastSweep;     //!< When (ms) the last check of the AFs ended
+    uint8_t failedSweeps;   //!< Checks of the AFs in a row that found no better AF (see RDS_AF_MAX_BACKOFF)
+    uint16_t switches;      //!< AF switches done
+    uint8_t savedFast;      //!< FAST tune setup restored after the check
+    bool muted;             //!< The audio was muted by the check
+} si473x_af_switch;
+
+/**
+ * @ingroup group16
+ *
+ * @brief RDS group as read from the device (see startRdsCapture)
+ */
+typedef struct
+{
+    uint32_t timestamp; //!< When (ms) the group was read
+    uint16_t frequency; //!< Frequency tuned when the group was read
+    uint16_t block[4];  //!< Blocks A to D
+    uint8_t ble;        //!< Block errors: BLEA (bits 7-6), BLEB, BLEC and BLED (bits 1-0); same order of FM_RDS_STATUS
+} si473x_rds_raw_group;
+
+/**
+ * @ingroup group16
+ *
+ * @brief Lock free ring buffer of raw RDS groups: the driver writes head, readRdsCapture writes tail
+ */
+typedef struct
+{
+    volatile si473x_rds_raw_group groups[SI473X_RDS_CAPTURE_SIZE]; //!< Entry of index i: groups[i % SI473X_RDS_CAPTURE_SIZE]
+    volatile uint16_t head;                                         //!< Groups written (free running)
+    volatile uint16_t tail;                                         //!< Groups read (free running)
+    volatile uint32_t dropped;                                      //!< Groups lost because the ring was full
+} si473x_rds_capture;
+
+/**
+ * @ingroup group08
+ *
+ * @brief Station found by scanBand (RSQ status of the channel)
+ */
+typedef struct
+{
+    uint16_t frequency;     //!< FM: 10 kHz units (10390 = 103.9 MHz); AM: kHz
+    uint8_t rssi;           //!< Received signal strength (dBuV)
+    uint8_t snr;            //!< Signal to noise ratio (dB)
+    uint8_t multipath;      //!< Multipath (0 = no multipath; 100 = full multipath). FM only (0 on AM)
+    int8_t frequencyOffset; //!< Signed frequency offset (kHz). FM only (0 on AM)
+} si473x_scan_entry;
+
+#define SI473X_STATION_DB_SIZE 32 // Stations kept by the background scan database
+
+#define SI473X_BGSCAN_IDLE 0     // startBackgroundScan was not called (or stopBackgroundScan was)
+#define SI473X_BGSCAN_TUNE 1     // The next channel will be tuned
+#define SI473X_BGSCAN_WAIT_STC 2 // Waiting for the end of the tune
+#define SI473X_BGSCAN_RDS 3      // Listening to the RDS of the channel
+
+/**
+ * @ingroup group08
+ *
+ * @brief Station record of the background scan database
+ */
+typedef struct
+{
+    uint16_t frequency; //!< FM: 10 kHz units (10390 = 103.9 MHz); AM: kHz
+    uint8_t rssi;       //!< Received signal strength (dBuV) on the last visit
+    uint8_t snr;        //!< Signal to noise ratio (dB) on the last visit
+    uint16_t pi;        //!< RDS Program Identification (0 = not received yet)
+    char ps[9];         //!< RDS Program Service name (empty = not received yet)
+    uint32_t lastSeen;  //!< When (ms) the station last passed the scan thresholds
+} si473x_station_record;
+
+/**
+ * @ingroup group08
+ *
+ * @brief Station database refreshed by processBackgroundScan
+ *
+ * @details order keeps the records sorted (best first), so getBestStation does not search the table.
+ */
+typedef struct
+{
+    si473x_station_record records[SI473X_STATION_DB_SIZE]; //!< Stations (no particular order)
+    uint8_t order[SI473X_STATION_DB_SIZE];                 //!< Indexes of records, the best station first
+    uint8_t count;                                         //!< Records used
+    uint8_t state;                                         //!< SI473X_BGSCAN_IDLE, _TUNE, _WAIT_STC or _RDS
+    uint16_t minimumFrequency;                             //!< Band scanned (taken from the receiver by startBackgroundScan)
+    uint16_t maximumFrequency;
+    uint16_t step;
+    uint16_t frequency;        //!< Channel being visited
+    uint16_t rdsWindowMs;      //!< Time the RDS of each station is listened to (0 = RSQ only)
+    uint32_t stateStart;       //!< When (ms) the current state started
+    uint32_t lastStcPoll;      //!< When (ms) STCINT was last read (WAIT_STC state, polling mode)
+    uint8_t visiting;          //!< Record of the channel being visited (RDS state)
+    uint16_t lastScore;        //!< RSSI + SNR of the previous channel if it passed the thresholds (0 = it did not)
+    uint16_t cycles;           //!< Complete passes over the band
+    uint16_t savedFrequency;   //!< Frequency restored by stopBackgroundScan
+    uint8_t savedFast;         //!< FAST tune setup restored by stopBackgroundScan
+} si473x_station_db;
+
+// Define SI473X_MULTI_DEVICE (compiler command line) to drive several devices (initContext, selectContext).
+// Without it no context is allocated: the globals are the state of the single device.
+// #define SI473X_MULTI_DEVICE
+
+/**
+ * @ingroup group22
+ *
+ * @brief Device state kept by the driver (one entry per global of SI4735.c)
+ *
+ * @details X(type, name, array dimension). It declares the fields of si473x_context
+ * @details and drives the copies done by selectContext. A new per-device global must be added here.
+ */
+#define SI473X_CONTEXT_STATE(X)                                                \
+    X(char, rds_buffer2A, [65])                                                \
+    X(char, rds_buffer2B, [33])                                                \
+    X(char, rds_buffer0A, [9])                                                 \
+    X(char, rds_time, [25])                                                    \
+    X(int, rdsTextAdress2A, )                                                  \
+    X(int, rdsTextAdress2B, )                                                  \
+    X(int, rdsTextAdress0A, )                                                  \
+    X(bool, rdsEndGroupA, )                                                    \
+    X(bool, rdsEndGroupB, )                                                    \
+    X(int16_t, deviceAddress, )                                                \
+    X(uint16_t, maxDelaySetFrequency, )                                        \
+    X(uint16_t, maxDelayAfterPouwerUp, )                                       \
+    X(unsigned long, maxSeekTime, )                                            \
+    X(uint8_t, lastTextFlagAB, )                                               \
+    X(uint8_t, resetPin, )                                                     \
+    X(uint8_t, currentTune, )                                                  \
+    X(uint16_t, currentMinimumFrequency, )                                     \
+    X(uint16_t, currentMaximumFrequency, )                                     \
+    X(uint16_t, currentWorkFrequency, )                                        \
+    X(uint16_t, currentStep, )                                                 \
+    X(uint8_t, lastMode, )                                                     \
+    X(uint8_t, currentAvcAmMaxGain, )                                          \
+    X(uint8_t, currentClockType, )                                             \
+    X(uint8_t, ctsIntEnable, )                                                 \
+    X(uint8_t, gpo2Enable, )                                                   \
+    X(uint16_t, refClock, )                                                    \
+    X(uint16_t, refClockPrescale, )                                            \
+    X(uint8_t, refClockSourcePin, )                                            \
+    X(si47x_frequency, currentFrequency, )                                     \
+    X(si47x_set_frequency, currentFrequencyParams, )                           \
+    X(si47x_rqs_status, currentRqsStatus, )                                    \
+    X(si47x_response_status, currentStatus, )                                  \
+    X(si47x_firmware_information, firmwareInfo, )                              \
+    X(si47x_rds_status, currentRdsStatus, )                                    \
+    X(si473x_rds_info, rdsInfo, )                                              \
+    X(si473x_rds_text_vote, rdsPsVote, )                                       \
+    X(si473x_rds_text_vote, rdsRtVote, )                                       \
+    X(char, rdsRtWork, [65])                                                   \
+    X(uint8_t, rdsRtAB, )                                                      \
+    X(uint8_t, rdsRtVersion, )                                                 \
+    X(uint16_t, rdsFrequency, )                                                \
+    X(bool, rdsCacheChecked, )                                                 \
+    X(uint16_t, rdsPiCandidate, )                                              \
+    X(bool, rdsGroupRemoved, )                                                 \
+    X(bool, rdsAfCheck, )                                                      \
+    X(si473x_rds_capture *, rdsCapture, )                                      \
+    X(uint8_t, rdsTextConfidence, )                                            \
+    X(si47x_agc_status, currentAgcStatus, )                                    \
+    X(si47x_ssb_mode, currentSSBMode, )                                        \
+    X(si473x_powerup, powerUp, )                                               \
+    X(uint8_t, volume, )                                                       \
+    X(uint8_t, currentAudioMode, )                                             \
+    X(uint8_t, currentSsbStatus, )                                             \
+    X(int8_t, audioMuteMcuPin, )                                               \
+    X(volatile uint8_t, ctsInterruptFlag, )                                    \
+    X(uint8_t, ctsWaitMode, )                                                  \
+    X(uint16_t, minDelayWaitSendLoop, )                                        \
+    X(uint16_t, maxDelayCtsInterrupt, )                                        \
+    X(volatile uint8_t, stcInterruptFlag, )                                    \
+    X(uint8_t, stcIntEnable, )                                                 \
+    X(uint16_t, maxDelayTuneComplete, )                                        \
+    X(bool, tuneCoalescing, )                                                  \
+    X(uint8_t, tunePending, )                                                  \
+    X(uint16_t, pendingTuneFrequency, )                                        \
+    X(uint8_t, tuneInProgress, )                                               \
+    X(uint32_t, tuneStartTime, )                                               \
+    X(uint32_t, lastStcPoll, )                                                 \
+    X(uint8_t, scanMinRssi, )                                                  \
+    X(uint8_t, scanMinSnr, )                                                   \
+    X(uint8_t, patchDownloadMode, )                                            \
+    X(uint16_t, minDelayPatchPoll, )                                           \
+    X(si473x_patch_result, patchResult, )                                      \
+    X(const uint8_t *, residentPatch, )                                        \
+    X(uint16_t, residentPatchId, )                                             \
+    X(bool, patchRetention, )                                                  \
+    X(uint32_t, eepromPatchThroughput, )                                       \
+    X(uint8_t, ctsReady, )                                                     \
+    X(si473x_command, commandQueue, [SI473X_CMD_QUEUE_SIZE])                   \
+    X(volatile uint8_t, commandQueueHead, )                                    \
+    X(volatile uint8_t, commandQueueTail, )                                    \
+    X(uint16_t, commandTicket, )                                               \
+    X(uint16_t, commandDoneTicket, )                                           \
+    X(uint8_t, commandEngineState, )                                           \
+    X(uint8_t, commandEngineBusy, )                                            \
+    X(uint32_t, commandStartTime, )                                            \
+    X(si47x_status, lastCommandStatus, )                                       \
+    X(si473x_property_cache, propertyCache, [SI473X_PROPERTY_CACHE_SIZE])      \
+    X(uint8_t, propertyCacheCount, )                                           \
+    X(uint8_t, propertyCacheNext, )                                            \
+    X(bool, propertyCacheEnabled, )                                            \
+    X(si473x_property_cache, propertyBatch, [SI473X_PROPERTY_BATCH_SIZE])      \
+    X(uint8_t, propertyBatchCount, )                                           \
+    X(uint8_t, propertyBatchLevel, )                                           \
+    X(uint8_t, propertyBatchDone, )                                            \
+    X(int32_t, propertyBatchError, )                                           \
+    X(int32_t, propertyBatchFailed, )                                          \
+    X(const si473x_transport *, transport, )
+
+/**
+ * @ingroup group22
+ *
+ * @brief Driver context of one SI473X device (see initContext and selectContext)
+ *
+ * @details The globals of SI4735.c are the state of the selected device. selectContext stores them
+ * @details on the context being left and loads them from the context being selected.
+ */
+typedef struct si473x_context
+{
+#define SI473X_CONTEXT_FIELD(type, name, dim) type name dim;
+    SI473X_CONTEXT_STATE(SI473X_CONTEXT_FIELD)
+#undef SI473X_CONTEXT_FIELD
+    uint16_t intPin;             //!< EXTI pin of the GPO2/INT line of the device (see SI4735_EXTI_Callback)
+    struct si473x_context *next; //!< Next context known by SI4735_EXTI_Callback
+} si473x_context;
+
 /**********************************************************************
  * SI4735 Class definition
  **********************************************************************/
@@ -1103,6 +1562,39 @@ extern uint8_t currentAudioMode; //!< Current audio mode used (ANALOG or DIGITAL
 extern uint8_t currentSsbStat;
 extern int8_t audioMuteMcuPin;
 
+extern volatile uint8_t ctsInterruptFlag; //!< Set by SI4735_EXTI_Callback when the device raises CTS on GPO2/INT.
+extern volatile uint8_t stcInterruptFlag; //!< Set by SI4735_EXTI_Callback; checked by waitTuneComplete.
+extern uint8_t stcIntEnable;              //!< STCIEN given to setGpioIen.
+extern uint16_t maxDelayTuneComplete;     //!< Max time (in ms) waitTuneComplete waits for STCINT.
+extern bool tuneCoalescing;               //!< true = frequencyUp/frequencyDown use requestFrequency.
+extern uint8_t tunePending;               //!< 1 = a requested frequency waits to be sent.
+extern uint8_t tuneInProgress;            //!< 1 = a coalescing tune was sent and STCINT was not seen yet.
+extern uint8_t scanMinRssi;               //!< Min RSSI (dBuV) of a channel stored by scanBand.
+extern uint8_t scanMinSnr;                //!< Min SNR (dB) of a channel stored by scanBand.
+extern uint8_t ctsWaitMode;               //!< CTS_WAIT_POLLING or CTS_WAIT_INTERRUPT.
+extern uint8_t patchDownloadMode;         //!< PATCH_DOWNLOAD_CTS or PATCH_DOWNLOAD_DELAY.
+extern uint16_t minDelayPatchPoll;        //!< Polling step (in us) of the CTS check after each patch line.
+extern si473x_patch_result patchResult;   //!< Result of the last patch download.
+extern const uint8_t *residentPatch;      //!< Patch held by the device since the last reset (NULL = none).
+extern bool patchRetention;               //!< The device keeps its patch through POWER_DOWN (see setPatchRetention).
+extern const uint8_t ssb_patch_content[]; //!< SSB patch built into SI4735.c (patch_init.h).
+extern const uint16_t size_content;       //!< Size of ssb_patch_content.
+extern const uint16_t ssb_patch_crc;      //!< SSB_PATCH_CRC of ssb_patch_content.
+extern uint32_t eepromPatchThroughput;    //!< Bytes per second of the last downloadPatchFromEeprom.
+extern uint16_t minDelayWaitSendLoop;     //!< Polling step of waitToSend (in us).
+extern uint16_t maxDelayCtsInterrupt;     //!< Max time (in ms) waitToSend waits for the CTS interrupt.
+
+extern volatile uint8_t commandQueueHead; //!< Index of the command being processed by the command engine.
+extern volatile uint8_t commandQueueTail; //!< Index where the next queued command will be stored.
+extern const si473x_transport *transport;  //!< I2C bus, time base and GPIO used to reach the device.
+extern bool propertyCacheEnabled;          //!< false = always sends the properties.
+extern si473x_rds_info rdsInfo;            //!< RDS data decoded by processRdsGroup.
+extern si473x_rds_text_vote rdsPsVote;     //!< Character votes of rds_buffer0A.
+extern si473x_rds_text_vote rdsRtVote;     //!< Character votes of rdsRtWork.
+extern char rdsRtWork[65];                 //!< Radio Text (2A or 2B) being received.
+extern bool rdsCacheEnabled;               //!< See setRdsCache.
+extern uint8_t rdsTextConfidence;          //!< Votes a PS/RT character needs to be shown (0 = no voting).
+
 void waitInterrupr(void);
 si47x_status getInterruptStatus();
 
@@ -1111,6 +1603,12 @@ si47x_status getInterruptStatus();
 // void setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t CTSIEN, uint8_t STCREP, uint8_t RSQREP);
 
 void sendProperty(uint16_t propertyNumber, uint16_t param);
+int32_t getCachedProperty(uint16_t propertyNumber);
+void setCachedProperty(uint16_t propertyNumber, uint16_t value);
+void invalidateCachedProperty(uint16_t propertyNumber);
+void beginProperties(void);
+void addProperty(uint16_t propertyNumber, uint16_t value);
+int32_t commitProperties(void);
 
 void sendSSBModeProperty();
 void disableFmDebug();
@@ -1157,13 +1655,80 @@ void getSsbAgcStatus();
 
 void reset(void);
 void waitToSend(void);
+void SI4735_EXTI_Callback(uint16_t GPIO_Pin);
+
+#ifdef SI473X_MULTI_DEVICE
+void initContext(si473x_context *ctx, const si473x_transport *t, int16_t address, uint16_t intPin);
+void selectContext(si473x_context *ctx);
+si473x_context *getContext(void);
+#endif
+
+/**
+ * @ingroup group06 Wait to send command
+ * @brief Selects how waitToSend detects the Clear to Send (CTS) condition.
+ * @details CTS_WAIT_INTERRUPT only takes effect when the device was powered up with CTSIEN = 1 (see setup_t)
+ * @details and the GPO2/INT pin drives an EXTI line whose callback calls SI4735_EXTI_Callback.
+ * @details If no interrupt arrives within maxDelayCtsInterrupt ms, waitToSend falls back to polling.
+ * @param mode CTS_WAIT_POLLING (default) or CTS_WAIT_INTERRUPT
+ */
+static inline void setCtsWaitMode(uint8_t mode)
+{
+    ctsWaitMode = mode;
+}
+
+/**
+ * @ingroup group06 Wait to send command
+ * @brief Sets the polling step used by waitToSend between two status reads.
+ * @see MIN_DELAY_WAIT_SEND_LOOP
+ * @param us delay in microseconds (default is 300us)
+ */
+static inline void setMinDelayWaitSendLoop(uint16_t us)
+{
+    minDelayWaitSendLoop = us;
+}
+
+/**
+ * @ingroup group06 Wait to send command
+ * @brief Sets how long waitToSend waits for the CTS interrupt before polling the device.
+ * @see MAX_DELAY_CTS_INTERRUPT
+ * @param ms timeout in ms (default is 10ms)
+ */
+static inline void setMaxDelayCtsInterrupt(uint16_t ms)
+{
+    maxDelayCtsInterrupt = ms;
+}
+
+/**
+ * @ingroup group06 Transport
+ * @brief Selects the transport (I2C bus, time base and GPIO) used to reach the device.
+ * @details Call it before setup. The default is stm32Transport (fakeTransport when built with SI473X_HOST).
+ * @see si473x_transport, stm32Transport, linuxTransport, fakeTransport
+ * @param t transport to be used
+ */
+static inline void setTransport(const si473x_transport *t)
+{
+    transport = t;
+}
+
+/**
+ * @ingroup group10 Property cache
+ * @brief Enables or disables the property shadow table.
+ * @details When enabled (default), sendProperty does not send a value the device already has
+ * @details and getProperty answers from the table when the value is known.
+ * @param enabled true or false
+ */
+static inline void setPropertyCache(bool enabled)
+{
+    propertyCacheEnabled = enabled;
+    invalidateCachedProperty(SI473X_ALL_PROPERTIES);
+}
 
 void setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN);
 void setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL);
 void setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t CTSIEN, uint8_t STCREP, uint8_t RSQREP);
 
 void setup( uint8_t defaultFunction);
-void setup_t(uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode, uint8_t clockType, uint8_t gpo2Enable);
+void setup_t(uint8_t ctsIen, uint8_t defaultFunction, uint8_t audioMode, uint8_t clockType, uint8_t gpo2En);
 
 void setRefClock(uint16_t refclk);
 void setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel);
@@ -1193,12 +1758,38 @@ void sendCommand(uint8_t cmd, int parameter_size, const uint8_t *parameter);
 void getCommandResponse(int num_of_bytes, uint8_t *response);
 si47x_status getStatusResponse();
 
+uint16_t queueCommand(uint8_t cmd, uint8_t argc, const uint8_t *args, uint8_t responseSize, uint8_t *response, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+void processCommandQueue(void);
+bool isCommandDone(uint16_t ticket);
+void flushCommandQueue(void);
+si47x_status runCommand(uint8_t cmd, uint8_t argc, const uint8_t *args, uint8_t responseSize, uint8_t *response);
+uint16_t queueProperty(uint16_t propertyNumber, uint16_t param, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+uint16_t queueStatus(uint8_t INTACK, uint8_t CANCEL, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+uint16_t queueReceivedSignalQuality(uint8_t INTACK, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+uint16_t queueRdsStatus(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+uint16_t queueFrequency(uint16_t freq, void (*callback)(uint8_t cmd, si47x_status status, uint8_t *response));
+
+/**
+ * @ingroup group21 Command engine
+ * @brief Returns true if there is no command waiting or running in the command engine.
+ * @see queueCommand, processCommandQueue
+ */
+static inline bool isCommandQueueEmpty(void)
+{
+    return commandQueueHead == commandQueueTail;
+}
+
 void setPowerUp(uint8_t CTSIEN, uint8_t GPO2OEN, uint8_t PATCH, uint8_t XOSCEN, uint8_t FUNC, uint8_t OPMODE);
 void radioPowerUp(void);
 void analogPowerUp(void);
 void powerDown(void);
 
-void setFrequency(uint16_t);
+bool setFrequency(uint16_t); // Was void: returns false if the tune did not complete (see waitTuneComplete)
+void sendTuneFrequency(uint16_t freq);
+bool isTuneComplete(void);
+bool waitTuneComplete(void);
+void requestFrequency(uint16_t freq);
+bool processPendingTune(void);
 
 void getStatus(uint8_t, uint8_t);
 
@@ -2338,6 +2929,46 @@ void static inline setSeekAmSNRThreshold(uint16_t value) { sendProperty(AM_SEEK_
 
 void setSeekAmRssiThreshold(uint16_t value);
 
+uint16_t scanBand(si473x_scan_entry *stations, uint16_t maxStations, uint16_t dwellMs, void (*showFunc)(uint16_t f));
+
+/**
+ * @ingroup group08 Band Scan
+ * @brief Sets the minimum RSSI and SNR of a channel stored by scanBand.
+ * @param rssi min RSSI in dBuV (default SCAN_MIN_RSSI)
+ * @param snr  min SNR in dB (default SCAN_MIN_SNR)
+ */
+static inline void setScanThreshold(uint8_t rssi, uint8_t snr)
+{
+    scanMinRssi = rssi;
+    scanMinSnr = snr;
+}
+
+void startBackgroundScan(si473x_station_db *db, uint16_t rdsWindowMs);
+bool processBackgroundScan(si473x_station_db *db);
+void stopBackgroundScan(si473x_station_db *db);
+
+/**
+ * @ingroup group08 Background Scan
+ * @brief Returns the station of a given rank (0 = the best one) of the background scan database.
+ * @details It does not search: the database is kept sorted by processBackgroundScan.
+ * @param db   database refreshed by processBackgroundScan
+ * @param rank 0 to getStationCount(db) - 1
+ * @return the station record or NULL if rank is not used
+ */
+static inline const si473x_station_record *getBestStation(const si473x_station_db *db, uint8_t rank)
+{
+    return (rank < db->count) ? &db->records[db->order[rank]] : NULL;
+}
+
+/**
+ * @ingroup group08 Background Scan
+ * @brief Returns the number of stations of the background scan database.
+ */
+static inline uint8_t getStationCount(const si473x_station_db *db)
+{
+    return db->count;
+}
+
 // FM Seek property configurations
 void setSeekFmLimits(uint16_t bottom, uint16_t top);
 void setSeekFmSpacing(uint16_t spacing);
@@ -2386,6 +3017,11 @@ void RdsInit();
 void static inline clearRdsBuffer() { RdsInit(); };
 void setRdsIntSource(uint8_t RDSRECV, uint8_t RDSSYNCLOST, uint8_t RDSSYNCFOUND, uint8_t RDSNEWBLOCKA, uint8_t RDSNEWBLOCKB);
 void getRdsStatus_t(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY);
+uint16_t processRdsGroup(void);
+uint8_t drainRdsFifo(uint16_t *updates);
+void setRdsGroupHandler(uint8_t group, si473x_rds_group_handler handler);
+void setRdsOdaHandler(void (*handler)(uint16_t aid, uint8_t group, uint16_t message));
+void setRdsTextHandler(void (*handler)(const char *text, uint8_t versionCode, uint8_t textAB));
 /**
  * @ingroup group16 RDS status
  *
@@ -2590,6 +3226,18 @@ char *getRdsText0A(void); // Gets the Station name
 char *getRdsText2A(void); // Gets the Radio Text
 char *getRdsText2B(void);
 bool getRdsAllData(char **stationName, char **stationInformation, char **programInformation, char **utcTime);
+void startAfSwitch(si473x_af_switch *af, uint8_t minRssi, uint8_t minSnr);
+bool processAfSwitch(si473x_af_switch *af);
+void stopAfSwitch(si473x_af_switch *af);
+void startRdsCapture(si473x_rds_capture *capture);
+uint16_t readRdsCapture(si473x_rds_capture *capture, si473x_rds_raw_group *groups, uint16_t max);
+char *formatRdsGroup(const si473x_rds_raw_group *group, char *line);
+bool parseRdsGroup(const char *line, si473x_rds_raw_group *group);
+uint16_t replayRdsGroup(const si473x_rds_raw_group *group);
+#ifdef SI473X_HOST
+uint32_t saveRdsCapture(si473x_rds_capture *capture, FILE *file);
+uint32_t replayRdsFile(FILE *file, void (*onGroup)(const si473x_rds_raw_group *group, uint16_t updates));
+#endif
 
 /**
  * @ingroup group16
@@ -2620,6 +3268,40 @@ static inline char *getRdsProgramInformation(void) { return getRdsText2A(); };
  */
 static inline char *getRdsStationInformation(void) { return getRdsText2B(); };
 
+/**
+ * @ingroup group16
+ * @brief Sets the votes a PS or RT character needs before it is shown
+ * @details A reception with no block errors adds 2 votes; one with corrected errors (BLE 1 or 2) adds 1.
+ * @details A different character on the same position takes the votes back. It lets setRdsConfig accept
+ * @details corrected blocks (BLETH 2) without showing wrong characters.
+ * @param confidence votes (default RDS_TEXT_CONFIDENCE); 0 = shows every character received (no voting)
+ * @see isRdsStationNameComplete, isRdsProgramInfoComplete
+ */
+static inline void setRdsTextConfidence(uint8_t confidence) { rdsTextConfidence = confidence; };
+
+/**
+ * @ingroup group16
+ * @brief Checks if all characters of the Station Name (rds_buffer0A) reached the confidence
+ * @return true when the four segments of the PS are confirmed
+ * @see setRdsTextConfidence
+ */
+static inline bool isRdsStationNameComplete(void) { return rdsPsVote.confirmed == 0x000F; };
+
+bool isRdsProgramInfoComplete(void);
+
+/**
+ * @ingroup group16
+ * @brief Enables or disables the RDS station cache
+ * @details When a station is left, its PS, PTY, Radio Text and AF list are kept (SI473X_RDS_CACHE_SIZE stations,
+ * @details least recently used replaced first). Back on the same frequency, they are shown as soon as a block A
+ * @details without errors confirms the PI; processRdsGroup then returns RDS_NEW_CACHED with the flags of the data.
+ * @details The cache is shared by all devices (see selectContext).
+ * @param enabled true = enabled (default)
+ * @see clearRdsCache
+ */
+static inline void setRdsCache(bool enabled) { rdsCacheEnabled = enabled; };
+void clearRdsCache(void);
+
 void mjdConverter(uint32_t mjd, uint32_t *year, uint32_t *month, uint32_t *day);
 char *getRdsTime(void);
 //char *getRdsDateTime(void);
@@ -2657,9 +3339,92 @@ void setFrequencyNBFM(uint16_t freq);
 si47x_firmware_query_library queryLibraryId();
 void patchPowerUp();
 bool downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size);
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Selects how the patch download waits for the device after each line.
+ * @details PATCH_DOWNLOAD_CTS polls the status byte (every minDelayPatchPoll us) and stops on ERR.
+ * @details PATCH_DOWNLOAD_DELAY waits 1 ms per line and does not check ERR (about 2 s for the full SSB patch).
+ * @details Both modes wait for CTS before writing a line, the first one included.
+ * @param mode PATCH_DOWNLOAD_CTS (default) or PATCH_DOWNLOAD_DELAY
+ */
+static inline void setPatchDownloadMode(uint8_t mode)
+{
+    patchDownloadMode = mode;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Sets the CTS polling step used after each patch line.
+ * @see MIN_DELAY_PATCH_POLL
+ * @param us time in microseconds
+ */
+static inline void setMinDelayPatchPoll(uint16_t us)
+{
+    minDelayPatchPoll = us;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Gets the line rejected by the device on the last patch download.
+ * @return int16_t line index (0 = first line) or -1 if the download did not fail
+ */
+static inline int16_t getPatchErrorLine()
+{
+    return patchResult.line;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Checks if the device may still hold a given patch (with setPatchRetention(true) the next load checks it first).
+ * @param patch patch content
+ * @return true if patch was the last patch loaded and the device was not reset since then
+ */
+static inline bool isPatchResident(const uint8_t *patch)
+{
+    return patch != NULL && patch == residentPatch;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Tells the driver whether the device keeps its patch RAM through POWER_DOWN.
+ * @details Only then loadPatch (and the other load functions) checks the patch of the device with GET_REV before
+ * @details downloading it again. Leave it false (default) unless your device is known to keep the patch: the check
+ * @details powers the device down and up, which costs more than it saves when the patch is always lost.
+ * @param retained true if the patch survives POWER_DOWN
+ */
+static inline void setPatchRetention(bool retained)
+{
+    patchRetention = retained;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Forgets the patch held by the device. Call it if the device is reset or powered off outside this library.
+ */
+static inline void clearResidentPatch()
+{
+    residentPatch = NULL;
+}
+
+/**
+ * @ingroup group17 Patch and SSB support
+ * @brief Gets the throughput of the last downloadPatchFromEeprom.
+ * @return uint32_t bytes per second
+ */
+static inline uint32_t getEepromPatchThroughput()
+{
+    return eepromPatchThroughput;
+}
 bool downloadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size);
 void loadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint8_t ssb_audiobw);
 void loadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size, uint8_t ssb_audiobw);
+bool downloadLzPatch(const uint8_t *patch, const uint16_t patch_size);
+uint16_t patchCrc16(const uint8_t *data, uint16_t size);
+si473x_patch_result downloadPatchChecked(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, uint16_t crc);
+si473x_patch_result downloadCompressedPatchChecked(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size, uint16_t crc);
+si473x_patch_result downloadLzPatchChecked(const uint8_t *patch, const uint16_t patch_size, uint16_t crc);
+void loadLzPatch(const uint8_t *patch, const uint16_t patch_size, uint8_t ssb_audiobw);
 si4735_eeprom_patch_header downloadPatchFromEeprom(int eeprom_i2c_address);
 void ssbPowerUp();
 
@@ -2682,9 +3447,8 @@ static inline void setMaxDelayPowerUp(uint16_t ms)
  * @ingroup   group08 Tune Frequency
  * @brief Set the Max Delay after Set Frequency
  *
- * @details After the set frequency command, the system need a time to get ready to the next set frequency (default value 30ms).
- * @details Why the waitToSend() does not work in this case? No idea for while!
- * @details A low value makes the getFrequency command inaccurate.
+ * @details Delay used by the seek functions between the seek command and the status query (default value 30ms).
+ * @details setFrequency does not use it anymore: it waits for STCINT (see setMaxDelayTuneComplete).
  *
  * @see  MAX_DELAY_AFTER_POWERUP
  * @param ms
@@ -2694,6 +3458,39 @@ static inline void setMaxDelaySetFrequency(uint16_t ms)
     maxDelaySetFrequency = ms;
 }
 
+/**
+ * @ingroup   group08 Tune Frequency
+ * @brief Sets the max time setFrequency waits for the end of the tune (STCINT).
+ * @details setFrequency returns as soon as the device reports the tune complete; this is just the timeout.
+ * @see MAX_DELAY_TUNE_COMPLETE, waitTuneComplete
+ * @param ms timeout in ms (default is 300ms)
+ */
+static inline void setMaxDelayTuneComplete(uint16_t ms)
+{
+    maxDelayTuneComplete = ms;
+}
+
+/**
+ * @ingroup   group08 Tune Frequency
+ * @brief Makes frequencyUp and frequencyDown coalesce the tunes (see requestFrequency).
+ * @details Call processPendingTune from the main loop when enabled.
+ * @param enabled true or false (default)
+ */
+static inline void setTuneCoalescing(bool enabled)
+{
+    tuneCoalescing = enabled;
+}
+
+/**
+ * @ingroup   group08 Tune Frequency
+ * @brief Checks if a coalescing tune is pending or in progress.
+ * @return true if the device is not on currentWorkFrequency yet
+ */
+static inline bool isTunePending()
+{
+    return tunePending || tuneInProgress;
+}
+
 /**
  * @ingroup group08 Tune Frequency step
  *
@@ -2830,9 +3627,9 @@ static inline void setAudioMuteMcuPin(int8_t pin)
  */
 static inline void setHardwareAudioMute(bool on)
 {
-    HAL_GPIO_WritePin(GPIO_SI473X_MUTE, GPIO_SI473X_PIN_MUTE, on ? GPIO_PIN_SET : GPIO_PIN_RESET);
-		 HAL_GPIO_WritePin(AMP_EN_GPIO_Port, AMP_EN_Pin, on ? GPIO_PIN_RESET : GPIO_PIN_SET);
-        HAL_Delay(1);
+    transport->gpioWrite(SI473X_GPIO_MUTE, on);
+    transport->gpioWrite(SI473X_GPIO_AMP_EN, !on);
+    transport->delayMs(1);
 }
 
 void convertToChar(uint16_t value, char *strValue, uint8_t len, uint8_t dot, uint8_t separator, bool remove_leading_zeros);
@@ -1,22 +1,166 @@
 #include "SI4735_HAL.h"
 
-	void i2cWrite(uint8_t *data, size_t len, uint16_t dev_addr)
+#ifndef SI473X_HOST
+#include "main.h"
+
+#ifdef SI473X_I2C_DMA
+	static volatile uint8_t i2cDmaDone = 1;  // 1 when the last DMA transfer finished
+	static volatile uint8_t i2cDmaError = 0; // 1 if the last DMA transfer failed
+
+	// Stops a DMA transfer that did not finish, so the buffer is no longer touched and the bus is free for the next one.
+	static void i2cAbortDma(uint16_t dev_addr)
+	{
+		uint32_t start = HAL_GetTick();
+		if (HAL_I2C_Master_Abort_IT(&hi2c1, dev_addr << 1) == HAL_OK)
+		{
+			// The abort ends in the I2C interrupt (DMA stopped, STOP sent)
+			while (HAL_I2C_GetState(&hi2c1) != HAL_I2C_STATE_READY && (HAL_GetTick() - start) < MAX_DELAY_TIME)
+				;
+			return;
+		}
+		// The HAL aborts master transfers only (not Mem_Write/Mem_Read): stops the DMA channels and starts the peripheral again
+		if (hi2c1.hdmatx != NULL)
+			HAL_DMA_Abort(hi2c1.hdmatx);
+		if (hi2c1.hdmarx != NULL)
+			HAL_DMA_Abort(hi2c1.hdmarx);
+		HAL_I2C_DeInit(&hi2c1);
+		HAL_I2C_Init(&hi2c1);
+	}
+	// Waits for the end of the DMA transfer started with status. The CPU is given to i2cIdleHook meanwhile.
+	// Returns false if the transfer could not start, failed or timed out (the transfer is aborted).
+	static bool i2cWaitDma(HAL_StatusTypeDef status, uint16_t dev_addr)
+	{
+		uint32_t start = HAL_GetTick();
+		if (status != HAL_OK)
+		{
+			i2cDmaDone = i2cDmaError = 1;
+			return false;
+		}
+		while (!i2cDmaDone)
+		{
+			if ((HAL_GetTick() - start) >= MAX_DELAY_TIME)
+			{
+				i2cAbortDma(dev_addr); // Timeout: gives up (same limit as the polling transfers)
+				i2cDmaError = i2cDmaDone = 1;
+				break;
+			}
+			i2cIdleHook();
+		}
+		return !i2cDmaError;
+	}
+	bool i2cWrite(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		if (len < I2C_DMA_MIN_LEN)
+			return HAL_I2C_Master_Transmit(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+		i2cDmaDone = i2cDmaError = 0;
+		return i2cWaitDma(HAL_I2C_Master_Transmit_DMA(&hi2c1, dev_addr << 1, data, len), dev_addr);
+	}
+	bool i2cWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to)
 	{
-		HAL_I2C_Master_Transmit(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME);
+		if (len < I2C_DMA_MIN_LEN)
+			return HAL_I2C_Mem_Write(&hi2c1, dev_addr << 1, to, 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+		i2cDmaDone = i2cDmaError = 0;
+		return i2cWaitDma(HAL_I2C_Mem_Write_DMA(&hi2c1, dev_addr << 1, to, 1, data, len), dev_addr);
 	}
-	void i2cWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to)
+	bool i2cRead(uint8_t *data, size_t len, uint16_t dev_addr)
 	{
-		HAL_I2C_Mem_Write(&hi2c1, dev_addr << 1, to, 1, data, len, MAX_DELAY_TIME);
+		if (len < I2C_DMA_MIN_LEN)
+			return HAL_I2C_Master_Receive(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+		i2cDmaDone = i2cDmaError = 0;
+		return i2cWaitDma(HAL_I2C_Master_Receive_DMA(&hi2c1, dev_addr << 1, data, len), dev_addr);
 	}
-	void i2cRead(uint8_t *data, size_t len, uint16_t dev_addr)
+	bool i2cReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from)
 	{
-		HAL_I2C_Master_Receive(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME);
+		if (len < I2C_DMA_MIN_LEN)
+			return HAL_I2C_Mem_Read(&hi2c1, dev_addr << 1, from, 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+		i2cDmaDone = i2cDmaError = 0;
+		return i2cWaitDma(HAL_I2C_Mem_Read_DMA(&hi2c1, dev_addr << 1, from, 1, data, len), dev_addr);
 	}
-	void i2cReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from)
+	// Call it from HAL_I2C_MasterTxCpltCallback, HAL_I2C_MasterRxCpltCallback, HAL_I2C_MemTxCpltCallback and
+	// HAL_I2C_MemRxCpltCallback of the application.
+	void i2cTransferCompleteCallback(I2C_HandleTypeDef *hi2c)
+	{
+		if (hi2c == &hi2c1)
+			i2cDmaDone = 1;
+	}
+	// Call it from HAL_I2C_ErrorCallback of the application.
+	void i2cTransferErrorCallback(I2C_HandleTypeDef *hi2c)
+	{
+		if (hi2c == &hi2c1)
+			i2cDmaError = i2cDmaDone = 1;
+	}
+#else
+	bool i2cWrite(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		return HAL_I2C_Master_Transmit(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+	}
+	bool i2cWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to)
+	{
+		return HAL_I2C_Mem_Write(&hi2c1, dev_addr << 1, to, 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+	}
+	bool i2cRead(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		return HAL_I2C_Master_Receive(&hi2c1, dev_addr << 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+	}
+	bool i2cReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from)
+	{
+		return HAL_I2C_Mem_Read(&hi2c1, dev_addr << 1, from, 1, data, len, MAX_DELAY_TIME) == HAL_OK;
+	}
+#endif
+	static bool i2cProbe(uint16_t dev_addr)
+	{
+		return HAL_I2C_Master_Transmit(&hi2c1, dev_addr << 1, NULL, 0, MAX_DELAY_TIME) == HAL_OK;
+	}
+	static void _delay(uint32_t ms)
+	{
+		HAL_Delay(ms);
+	}
+	static void gpioWrite(uint8_t pin, bool value)
+	{
+		switch (pin)
+		{
+		case SI473X_GPIO_RESET:
+			HAL_GPIO_WritePin(GPIO_SI473X, GPIO_SI473X_PIN, value ? GPIO_PIN_SET : GPIO_PIN_RESET);
+			break;
+		case SI473X_GPIO_MUTE:
+			HAL_GPIO_WritePin(GPIO_SI473X_MUTE, GPIO_SI473X_PIN_MUTE, value ? GPIO_PIN_SET : GPIO_PIN_RESET);
+			break;
+		case SI473X_GPIO_AMP_EN:
+			HAL_GPIO_WritePin(AMP_EN_GPIO_Port, AMP_EN_Pin, value ? GPIO_PIN_SET : GPIO_PIN_RESET);
+			break;
+		}
+	}
+	// Called while a DMA transfer is in progress. Redefine it to run other tasks (UI, audio) or to sleep (__WFI).
+	__weak void i2cIdleHook(void)
 	{
-		HAL_I2C_Mem_Read(&hi2c1, dev_addr << 1, from, 1, data, len, MAX_DELAY_TIME);
 	}
 	uint32_t _millis()
 	{
 		return HAL_GetTick();
-	}
\ No newline at end of file
+	}
+	void _delayMicroseconds(uint32_t us)
+	{
+		// Counts SysTick ticks (the HAL 1 ms time base), so it works without a dedicated timer.
+		uint32_t ticks = us * (SystemCoreClock / 1000000U);
+		uint32_t reload = SysTick->LOAD + 1;
+		uint32_t last = SysTick->VAL;
+		uint32_t elapsed = 0;
+		while (elapsed < ticks)
+		{
+			uint32_t now = SysTick->VAL;
+			elapsed += (last >= now) ? (last - now) : (last + reload - now);
+			last = now;
+		}
+	}
+	const si473x_transport stm32Transport = {
+		i2cWrite,
+		i2cWriteTo,
+		i2cRead,
+		i2cReadFrom,
+		i2cProbe,
+		_millis,
+		_delay,
+		_delayMicroseconds,
+		gpioWrite
+	};
+#endif
\ No newline at end of file
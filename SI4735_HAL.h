@@ -4,21 +4,118 @@
 #define BUFFERLEN 32
 #define MAX_DELAY_TIME 1000
 
+// Uncomment (or define it on the compiler command line) to transfer data through DMA.
+// The CPU is released (see i2cIdleHook) while the bytes are on the bus.
+// The I2C DMA channels and the I2C event/error interrupts must be enabled on CubeMX.
+// #define SI473X_I2C_DMA
+#define I2C_DMA_MIN_LEN 8 // Shorter transfers are done by polling (DMA setup costs more than the transfer)
+
+// Define SI473X_HOST on the compiler command line to build the driver on a PC (Linux i2c-dev or fake transport).
+// #define SI473X_HOST
+
+#ifndef SI473X_HOST
 #define GPIO_SI473X GPIOB
 #define GPIO_SI473X_PIN GPIO_PIN_5
 
 #define GPIO_SI473X_MUTE GPIOB
 #define GPIO_SI473X_PIN_MUTE GPIO_PIN_9
 
+#define GPIO_SI473X_INT GPIOB          // GPO2/INT pin of the SI473X (EXTI line used by the CTS interrupt)
+#define GPIO_SI473X_PIN_INT GPIO_PIN_4
+#define GPIO_SI473X_INT_IRQn EXTI4_15_IRQn // EXTI interrupt of the INT pins (GPIO_PIN_4 to GPIO_PIN_15 on STM32F0)
+
 #include "stm32f0xx_hal.h"
+#define SI473X_MASK_INT() HAL_NVIC_DisableIRQ(GPIO_SI473X_INT_IRQn)   // SI4735_EXTI_Callback is not called until SI473X_UNMASK_INT
+#define SI473X_UNMASK_INT() HAL_NVIC_EnableIRQ(GPIO_SI473X_INT_IRQn)
+#else
+#define GPIO_SI473X_PIN_INT 0x0010     // Same value as GPIO_PIN_4. Pass it to SI4735_EXTI_Callback from the host interrupt handler.
+#define SI473X_MASK_INT()              // The host interrupt handlers run on the thread of the driver
+#define SI473X_UNMASK_INT()
+
+#include <stdint.h>
+#include <stddef.h>
+#endif
 #include "stdbool.h"
 #include "string.h"
 
+// Logical pins driven through si473x_transport.gpioWrite
+#define SI473X_GPIO_RESET 0  // RST pin of the SI473X
+#define SI473X_GPIO_MUTE 1   // External audio mute circuit (high = muted)
+#define SI473X_GPIO_AMP_EN 2 // Audio amplifier enable (low = enabled)
+
+/**
+ * @brief Transport used by the driver to reach the device (I2C bus, time base and GPIO).
+ *
+ * @details SI4735.c never calls the MCU HAL directly. It goes through the transport selected by setTransport().
+ * @details stm32Transport (STM32 HAL), linuxTransport (/dev/i2c-N) and fakeTransport (in-memory device) are available.
+ */
+typedef struct
+{
+	bool (*write)(uint8_t *data, size_t len, uint16_t dev_addr);                      // Writes len bytes to the device (false on bus error)
+	bool (*writeTo)(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to);       // Writes len bytes to a register (EEPROM address)
+	bool (*read)(uint8_t *data, size_t len, uint16_t dev_addr);                       // Reads len bytes from the device (false on bus error)
+	bool (*readFrom)(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from);    // Reads len bytes from a register (EEPROM address)
+	bool (*probe)(uint16_t dev_addr);                                                 // true if the device acknowledges its address
+	uint32_t (*millis)(void);                                                         // Milliseconds since start up
+	void (*delayMs)(uint32_t ms);
+	void (*delayUs)(uint32_t us);
+	void (*gpioWrite)(uint8_t pin, bool value);                                       // Sets a SI473X_GPIO_* pin
+} si473x_transport;
+
+#ifndef SI473X_HOST
 extern I2C_HandleTypeDef hi2c1;
+extern const si473x_transport stm32Transport;
 
-	void i2cWrite(uint8_t *data, size_t len, uint16_t dev_addr);
-	void i2cWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to);
-	void i2cRead(uint8_t *data, size_t len, uint16_t dev_addr);
-	void i2cReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from);
+	bool i2cWrite(uint8_t *data, size_t len, uint16_t dev_addr);
+	bool i2cWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to);
+	bool i2cRead(uint8_t *data, size_t len, uint16_t dev_addr);
+	bool i2cReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from);
 	uint32_t _millis(void);
+	void _delayMicroseconds(uint32_t us);
+	void i2cIdleHook(void);
+#ifdef SI473X_I2C_DMA
+	// The HAL I2C callbacks belong to the application (other I2C handles may use them). Forward them:
+	// HAL_I2C_MasterTxCpltCallback, HAL_I2C_MasterRxCpltCallback, HAL_I2C_MemTxCpltCallback and
+	// HAL_I2C_MemRxCpltCallback call i2cTransferCompleteCallback; HAL_I2C_ErrorCallback calls i2cTransferErrorCallback.
+	// Without them the DMA transfers end on MAX_DELAY_TIME and report an error.
+	void i2cTransferCompleteCallback(I2C_HandleTypeDef *hi2c);
+	void i2cTransferErrorCallback(I2C_HandleTypeDef *hi2c);
+#endif
+#define SI473X_DEFAULT_TRANSPORT (&stm32Transport)
+#else
+#ifdef __linux__
+extern const si473x_transport linuxTransport;
+
+	bool linuxTransportOpen(const char *device);
+	void linuxTransportClose(void);
+	// Drives a SI473X_GPIO_* pin with a sysfs GPIO line (-1 = not connected). Without RST the board must reset the device.
+	bool linuxTransportSetGpio(uint8_t pin, int gpio);
+#endif
+extern const si473x_transport fakeTransport;
+
+/**
+ * @brief Device model attached to the fake transport.
+ *
+ * @details onWrite receives every byte array written to the device; onRead fills the bytes read from it.
+ * @details A NULL model makes the fake answer CTS (0x80) followed by zeros to any read.
+ */
+typedef struct
+{
+	void (*onWrite)(const uint8_t *data, size_t len, uint16_t dev_addr);
+	void (*onRead)(uint8_t *data, size_t len, uint16_t dev_addr);
+	void (*onGpio)(uint8_t pin, bool value);
+	void (*onTick)(uint64_t now);  // Called when the virtual clock moves (now in us). Use it to raise interrupts.
+} fake_device_model;
+
+extern uint32_t fakeWriteCount;    // Number of write transactions
+extern uint32_t fakeReadCount;     // Number of read transactions
+extern uint32_t fakeBytesOnBus;    // Bytes moved on the bus (address bytes not included)
+extern uint32_t fakeBusUsPerByte;  // Virtual time spent on the bus per byte (90 us ~ 100 kHz)
+
+	void fakeTransportAttach(const fake_device_model *model);
+	void fakeTransportReset(void);
+	uint64_t fakeTransportMicros(void);
+	void fakeTransportAdvance(uint32_t us);
+#define SI473X_DEFAULT_TRANSPORT (&fakeTransport)
+#endif
 #endif // _SI4735_HAL_H_
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "SI4735_HAL.h"
+
+#ifdef SI473X_HOST
+	// In-memory transport: forwards the bus traffic to a device model and keeps a virtual clock.
+	// Delays and bus transfers advance the clock instead of sleeping, so runs are fast and repeatable.
+
+	static const fake_device_model *fakeModel = NULL;
+	static uint64_t fakeClock = 0; // virtual time in us
+
+	uint32_t fakeWriteCount = 0;
+	uint32_t fakeReadCount = 0;
+	uint32_t fakeBytesOnBus = 0;
+	uint32_t fakeBusUsPerByte = 90;
+
+	void fakeTransportAttach(const fake_device_model *model)
+	{
+		fakeModel = model;
+	}
+	void fakeTransportReset(void)
+	{
+		fakeClock = 0;
+		fakeWriteCount = fakeReadCount = fakeBytesOnBus = 0;
+	}
+	uint64_t fakeTransportMicros(void)
+	{
+		return fakeClock;
+	}
+	static void fakeTick(uint64_t us)
+	{
+		fakeClock += us;
+		if (fakeModel && fakeModel->onTick)
+			fakeModel->onTick(fakeClock);
+	}
+	void fakeTransportAdvance(uint32_t us)
+	{
+		fakeTick(us);
+	}
+	static void fakeBus(size_t len)
+	{
+		fakeBytesOnBus += len;
+		fakeTick((uint64_t)(len + 1) * fakeBusUsPerByte); // +1: address byte
+	}
+	static bool fakeWrite(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		fakeWriteCount++;
+		fakeBus(len);
+		if (fakeModel && fakeModel->onWrite)
+			fakeModel->onWrite(data, len, dev_addr);
+		return true;
+	}
+	static bool fakeWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to)
+	{
+		uint8_t buffer[BUFFERLEN + 1];
+		if (len > BUFFERLEN)
+			return false;
+		buffer[0] = (uint8_t)to;
+		memcpy(&buffer[1], data, len);
+		return fakeWrite(buffer, len + 1, dev_addr);
+	}
+	static bool fakeRead(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		fakeReadCount++;
+		fakeBus(len);
+		if (fakeModel && fakeModel->onRead)
+		{
+			fakeModel->onRead(data, len, dev_addr);
+			return true;
+		}
+		memset(data, 0, len);
+		if (len)
+			data[0] = 0x80; // CTS
+		return true;
+	}
+	static bool fakeReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from)
+	{
+		uint8_t reg = (uint8_t)from;
+		return fakeWrite(&reg, 1, dev_addr) && fakeRead(data, len, dev_addr);
+	}
+	static bool fakeProbe(uint16_t dev_addr)
+	{
+		fakeBus(0);
+		return fakeModel != NULL || dev_addr == 0x11;
+	}
+	static uint32_t fakeMillis(void)
+	{
+		fakeTick(1); // Models the CPU time of the caller, so busy loops on millis() move forward
+		return (uint32_t)(fakeClock / 1000);
+	}
+	static void fakeDelayUs(uint32_t us)
+	{
+		fakeTick(us);
+	}
+	static void fakeDelayMs(uint32_t ms)
+	{
+		fakeTick((uint64_t)ms * 1000);
+	}
+	static void fakeGpioWrite(uint8_t pin, bool value)
+	{
+		if (fakeModel && fakeModel->onGpio)
+			fakeModel->onGpio(pin, value);
+	}
+
+	const si473x_transport fakeTransport = {
+		fakeWrite,
+		fakeWriteTo,
+		fakeRead,
+		fakeReadFrom,
+		fakeProbe,
+		fakeMillis,
+		fakeDelayMs,
+		fakeDelayUs,
+		fakeGpioWrite
+	};
+#endif
\ No newline at end of file
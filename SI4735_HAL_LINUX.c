@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 199309L // nanosleep and clock_gettime under -std=c99
+#include "SI4735_HAL.h"
+
+#if defined(SI473X_HOST) && defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+	// Linux transport: talks to the SI473X through /dev/i2c-N (native bus or USB-I2C adapter).
+	// RST, mute and amplifier pins are driven through sysfs GPIO lines (see linuxTransportSetGpio); most USB-I2C
+	// adapters have none, then the board must reset the device.
+
+#define LINUX_GPIO_PINS 3 // SI473X_GPIO_RESET, SI473X_GPIO_MUTE and SI473X_GPIO_AMP_EN
+
+	static int i2cFd = -1;
+	static int gpioFd[LINUX_GPIO_PINS] = {-1, -1, -1}; // value file of the sysfs line of each pin
+	static bool resetReported = false;
+
+	bool linuxTransportOpen(const char *device)
+	{
+		linuxTransportClose();
+		i2cFd = open(device, O_RDWR);
+		return i2cFd >= 0;
+	}
+	void linuxTransportClose(void)
+	{
+		if (i2cFd >= 0)
+			close(i2cFd);
+		i2cFd = -1;
+	}
+	static int linuxTransfer(struct i2c_msg *msgs, int count)
+	{
+		struct i2c_rdwr_ioctl_data data = {msgs, count};
+		return ioctl(i2cFd, I2C_RDWR, &data);
+	}
+	static bool linuxWrite(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		struct i2c_msg msg = {dev_addr, 0, len, data};
+		return linuxTransfer(&msg, 1) >= 0;
+	}
+	static bool linuxWriteTo(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t to)
+	{
+		uint8_t buffer[BUFFERLEN + 1];
+		struct i2c_msg msg = {dev_addr, 0, len + 1, buffer};
+		if (len > BUFFERLEN)
+			return false;
+		buffer[0] = (uint8_t)to;
+		memcpy(&buffer[1], data, len);
+		return linuxTransfer(&msg, 1) >= 0;
+	}
+	static bool linuxRead(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		struct i2c_msg msg = {dev_addr, I2C_M_RD, len, data};
+		return linuxTransfer(&msg, 1) >= 0;
+	}
+	static bool linuxReadFrom(uint8_t *data, size_t len, uint16_t dev_addr, uint16_t from)
+	{
+		uint8_t reg = (uint8_t)from;
+		struct i2c_msg msgs[] = {{dev_addr, 0, 1, &reg}, {dev_addr, I2C_M_RD, len, data}};
+		return linuxTransfer(msgs, 2) >= 0;
+	}
+	static bool linuxProbe(uint16_t dev_addr)
+	{
+		uint8_t dummy;
+		struct i2c_msg msg = {dev_addr, I2C_M_RD, 1, &dummy};
+		return linuxTransfer(&msg, 1) >= 0;
+	}
+	static uint32_t linuxMillis(void)
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+	}
+	static void linuxDelayUs(uint32_t us)
+	{
+		struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+		while (nanosleep(&ts, &ts) != 0 && errno == EINTR) // A signal: sleeps the remaining time
+			;
+	}
+	static void linuxDelayMs(uint32_t ms)
+	{
+		linuxDelayUs(ms * 1000);
+	}
+	static bool linuxWriteFile(const char *path, const char *text)
+	{
+		int fd = open(path, O_WRONLY);
+		bool ok;
+		if (fd < 0)
+			return false;
+		ok = write(fd, text, strlen(text)) == (ssize_t)strlen(text);
+		close(fd);
+		return ok;
+	}
+	bool linuxTransportSetGpio(uint8_t pin, int gpio)
+	{
+		char path[64];
+		if (pin >= LINUX_GPIO_PINS)
+			return false;
+		if (gpioFd[pin] >= 0)
+			close(gpioFd[pin]);
+		gpioFd[pin] = -1;
+		if (gpio < 0)
+			return true;
+		snprintf(path, sizeof(path), "%d", gpio);
+		linuxWriteFile("/sys/class/gpio/export", path); // Fails if the line is already exported
+		snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/direction", gpio);
+		if (!linuxWriteFile(path, "out"))
+			return false;
+		snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value", gpio);
+		gpioFd[pin] = open(path, O_WRONLY);
+		return gpioFd[pin] >= 0;
+	}
+	static void linuxGpioWrite(uint8_t pin, bool value)
+	{
+		if (pin < LINUX_GPIO_PINS && gpioFd[pin] >= 0)
+		{
+			if (lseek(gpioFd[pin], 0, SEEK_SET) < 0 || write(gpioFd[pin], value ? "1" : "0", 1) != 1)
+				fprintf(stderr, "SI473X: cannot set GPIO pin %u\n", pin);
+			return;
+		}
+		// Mute and amplifier pins are optional; a missing reset leaves the device in its previous state
+		if (pin == SI473X_GPIO_RESET && !resetReported)
+		{
+			fprintf(stderr, "SI473X: RST is not driven (see linuxTransportSetGpio); the board must reset the device\n");
+			resetReported = true;
+		}
+	}
+
+	const si473x_transport linuxTransport = {
+		linuxWrite,
+		linuxWriteTo,
+		linuxRead,
+		linuxReadFrom,
+		linuxProbe,
+		linuxMillis,
+		linuxDelayMs,
+		linuxDelayUs,
+		linuxGpioWrite
+	};
+#endif
\ No newline at end of file
@@ -0,0 +1,797 @@
+#include "SI4735_SIM.h"
+
+#ifdef SI473X_HOST
+	// Command and property numbers (AN332). SI4735.h is not included here: it carries the SSB patch content.
+	#define SIM_POWER_UP 0x01
+	#define SIM_GET_REV 0x10
+	#define SIM_POWER_DOWN 0x11
+	#define SIM_SET_PROPERTY 0x12
+	#define SIM_GET_PROPERTY 0x13
+	#define SIM_GET_INT_STATUS 0x14
+	#define SIM_PATCH_ARGS 0x15
+	#define SIM_PATCH_DATA 0x16
+	#define SIM_FM_TUNE_FREQ 0x20
+	#define SIM_FM_SEEK_START 0x21
+	#define SIM_FM_TUNE_STATUS 0x22
+	#define SIM_FM_RSQ_STATUS 0x23
+	#define SIM_FM_RDS_STATUS 0x24
+	#define SIM_AM_TUNE_FREQ 0x40
+	#define SIM_AM_SEEK_START 0x41
+	#define SIM_AM_TUNE_STATUS 0x42
+	#define SIM_AM_RSQ_STATUS 0x43
+	#define SIM_NBFM_TUNE_FREQ 0x50
+	#define SIM_NBFM_TUNE_STATUS 0x52
+	#define SIM_NBFM_RSQ_STATUS 0x53
+
+	#define SIM_GPO_IEN 0x0001
+	#define SIM_FM_SEEK_BAND_BOTTOM 0x1400
+	#define SIM_FM_SEEK_BAND_TOP 0x1401
+	#define SIM_FM_SEEK_FREQ_SPACING 0x1402
+	#define SIM_FM_SEEK_TUNE_SNR_THRESHOLD 0x1403
+	#define SIM_FM_SEEK_TUNE_RSSI_THRESHOLD 0x1404
+	#define SIM_FM_RDS_INT_FIFO_COUNT 0x1501
+	#define SIM_FM_RDS_CONFIG 0x1502
+	#define SIM_AM_SEEK_BAND_BOTTOM 0x3400
+	#define SIM_AM_SEEK_BAND_TOP 0x3401
+	#define SIM_AM_SEEK_FREQ_SPACING 0x3402
+	#define SIM_AM_SEEK_SNR_THRESHOLD 0x3403
+	#define SIM_AM_SEEK_RSSI_THRESHOLD 0x3404
+	#define SIM_RX_VOLUME 0x4000
+
+	#define SIM_CTS 0x80
+	#define SIM_ERR 0x40
+	#define SIM_RSQINT 0x08
+	#define SIM_RDSINT 0x04
+	#define SIM_STCINT 0x01
+
+	sim_timing simTiming;
+	sim_stats simStats;
+
+	static sim_station stations[SIM_MAX_STATIONS];
+	static uint8_t stationCount = 0;
+	static int32_t patchErrorAt = -1; // patch line answered with ERR (-1 = none)
+	static bool patchRetention = false; // the patch RAM survives POWER_DOWN (see simSetPatchRetention)
+	static uint8_t rdsErrorPercent = 0; // blocks received with errors (see simSetRdsBlockErrors)
+	static uint32_t rdsErrorSeed = 1;
+	static void (*interruptHandler)(uint16_t pin) = NULL;
+	static const uint8_t *eepromContent = NULL; // 24Cxx EEPROM on the bus (see simAttachEeprom)
+	static size_t eepromSize;
+	static uint16_t eepromAddress, eepromPointer;
+
+	typedef struct
+	{
+		bool powered;
+		bool fm;            // FM (or NBFM) function
+		bool ctsIen;        // CTS interrupt enabled (POWER_UP)
+		bool patchMode;     // POWER_UP with PATCH set: waiting for patch lines
+		bool ctsNotified;   // CTS interrupt already raised for the current command
+		bool stcPending;
+		bool stcInt;
+		bool bltf;
+		bool seeking;       // the pending STC is a seek (the frequency moves channel by channel)
+		bool seekUp;
+		uint16_t seekFrom;
+		uint8_t err;
+		uint16_t patchId;   // 0 = no patch; otherwise checksum of the patch received
+		uint16_t patchLine; // patch lines received since the POWER_UP with PATCH set
+		uint16_t patchRevId; // patch ID reported by GET_REV (declared by the last 0x15 line: 0x15 00 00 00 00 00 IDH IDL)
+		uint64_t ctsTime;   // when the current command is done
+		uint64_t stcTime;   // when the current tune/seek is done
+		uint16_t frequency;
+		uint8_t response[16];
+		uint8_t responseSize;
+		// properties
+		uint16_t propNumber[SIM_MAX_PROPERTIES];
+		uint16_t propValue[SIM_MAX_PROPERTIES];
+		uint8_t propCount;
+		// RDS
+		int8_t station;     // index of the tuned station (-1 = none)
+		uint64_t rdsStart;  // when the first RDS group of the station is available
+		uint32_t rdsGenerated;
+		uint16_t fifo[SIM_RDS_FIFO_SIZE][4];
+		uint8_t fifoBle[SIM_RDS_FIFO_SIZE]; // BLEA..BLED as reported by byte 12 of FM_RDS_STATUS
+		uint8_t fifoHead;
+		uint8_t fifoCount;
+		bool groupLost;
+		bool rdsRecv;       // RDSRECV interrupt bit: latched when the FIFO reaches FM_RDS_INT_FIFO_COUNT, cleared by INTACK
+		uint16_t lastGroup[4];
+		uint8_t lastBle;
+		// kept by powerDown
+		uint16_t patchRamId, patchRamRevId; // patch held by the patch RAM (0 = none)
+		uint16_t address;   // I2C bus address (0 = not on the bus)
+		uint8_t resetPin;   // transport pin wired to the RST line of this chip
+		uint16_t intPin;    // pin passed to the interrupt handler by this chip
+	} sim_chip;
+
+	static sim_chip chips[SIM_MAX_CHIPS];
+	static sim_chip *chip = &chips[0]; // chip addressed by the last transaction (or by simSelectChip)
+
+	static const sim_station defaultStations[] = {
+		{8810, true, 45, 25, 0xE201, 10, false, "CLASSIC", "Mozart - Symphony No. 40", {21, 47}, 2},
+		{9130, true, 38, 20, 0xE302, 1, false, "NEWS 91", "Headlines every 30 minutes", {}, 0},
+		{9650, true, 28, 12, 0x0000, 0, false, "", "", {}, 0},
+		{10010, true, 52, 30, 0xE404, 10, true, "POP 100", "Now playing: the top 40", {36, 95, 121}, 3},
+		{10390, true, 60, 35, 0xE505, 5, false, "ROCK FM", "Rock around the clock", {52}, 1},
+		{10650, true, 22, 8, 0xE606, 3, false, "INFO", "Traffic and weather", {}, 0},
+		{570, false, 50, 25, 0, 0, false, "", "", {}, 0},
+		{810, false, 42, 20, 0, 0, false, "", "", {}, 0},
+		{1020, false, 30, 12, 0, 0, false, "", "", {}, 0},
+		{1440, false, 26, 9, 0, 0, false, "", "", {}, 0}
+	};
+
+	static uint64_t simNow(void)
+	{
+		return fakeTransportMicros();
+	}
+
+	static uint16_t getProperty(uint16_t property)
+	{
+		for (uint8_t i = 0; i < chip->propCount; i++)
+			if (chip->propNumber[i] == property)
+				return chip->propValue[i];
+		return 0;
+	}
+	static bool setProperty(uint16_t property, uint16_t value)
+	{
+		uint8_t i;
+		for (i = 0; i < chip->propCount; i++)
+			if (chip->propNumber[i] == property)
+				break;
+		if (i == SIM_MAX_PROPERTIES)
+			return false;
+		if (i == chip->propCount)
+			chip->propCount++;
+		chip->propNumber[i] = property;
+		chip->propValue[i] = value;
+		return true;
+	}
+	static void resetProperties(void)
+	{
+		chip->propCount = 0;
+		setProperty(SIM_FM_SEEK_BAND_BOTTOM, 8750);
+		setProperty(SIM_FM_SEEK_BAND_TOP, 10790);
+		setProperty(SIM_FM_SEEK_FREQ_SPACING, 10);
+		setProperty(SIM_FM_SEEK_TUNE_SNR_THRESHOLD, 3);
+		setProperty(SIM_FM_SEEK_TUNE_RSSI_THRESHOLD, 20);
+		setProperty(SIM_AM_SEEK_BAND_BOTTOM, 520);
+		setProperty(SIM_AM_SEEK_BAND_TOP, 1710);
+		setProperty(SIM_AM_SEEK_FREQ_SPACING, 10);
+		setProperty(SIM_AM_SEEK_SNR_THRESHOLD, 5);
+		setProperty(SIM_AM_SEEK_RSSI_THRESHOLD, 25);
+		setProperty(SIM_RX_VOLUME, 63);
+	}
+	static void powerDown(void)
+	{
+		memset(chip, 0, offsetof(sim_chip, patchRamId));
+		chip->station = -1;
+		resetProperties();
+	}
+
+	// Signal seen at freq: full level on the station, some leakage on the adjacent channel, noise elsewhere.
+	static int8_t signalAt(uint16_t freq, uint8_t *rssi, uint8_t *snr)
+	{
+		uint16_t adjacent = chip->fm ? 10 : 9;
+		*rssi = 6;
+		*snr = 0;
+		for (uint8_t i = 0; i < stationCount; i++)
+		{
+			if (stations[i].fm != chip->fm)
+				continue;
+			if (stations[i].frequency == freq)
+			{
+				*rssi = stations[i].rssi;
+				*snr = stations[i].snr;
+				return i;
+			}
+			if (stations[i].frequency + adjacent >= freq && stations[i].frequency <= freq + adjacent && stations[i].rssi > 20)
+			{
+				*rssi = stations[i].rssi - 20;
+				*snr = 1;
+			}
+		}
+		return -1;
+	}
+	static bool isValid(uint8_t rssi, uint8_t snr)
+	{
+		if (chip->fm)
+			return rssi >= getProperty(SIM_FM_SEEK_TUNE_RSSI_THRESHOLD) && snr >= getProperty(SIM_FM_SEEK_TUNE_SNR_THRESHOLD);
+		return rssi >= getProperty(SIM_AM_SEEK_RSSI_THRESHOLD) && snr >= getProperty(SIM_AM_SEEK_SNR_THRESHOLD);
+	}
+
+	static uint32_t rdsRandom(void)
+	{
+		rdsErrorSeed = rdsErrorSeed * 1103515245 + 12345;
+		return (rdsErrorSeed >> 16) & 0x7FFF;
+	}
+	// Receives a group over a noisy channel (simSetRdsBlockErrors): BLE 1 blocks are corrected; BLE 2 blocks
+	// may be miscorrected (one wrong bit); BLE 3 blocks are garbage. Returns false if a block is over its BLETH.
+	static bool rdsReceive(uint16_t *group, uint8_t *ble)
+	{
+		uint16_t config = getProperty(SIM_FM_RDS_CONFIG);
+		*ble = 0;
+		for (uint8_t i = 0; i < 4; i++)
+		{
+			uint8_t level = 0;
+			if (rdsRandom() % 100 < rdsErrorPercent)
+				level = 1 + rdsRandom() % 3;
+			if (level == 2 && (rdsRandom() & 1))
+				group[i] ^= (uint16_t)(1 << (rdsRandom() % 16));
+			else if (level == 3)
+				group[i] ^= (uint16_t)(rdsRandom() | 1);
+			if (level > ((config >> (14 - i * 2)) & 0x03))
+				return false;
+			*ble |= (uint8_t)(level << (6 - i * 2));
+		}
+		return true;
+	}
+	static void rdsPush(const uint16_t *group, uint8_t ble)
+	{
+		uint8_t tail;
+		if (chip->fifoCount == SIM_RDS_FIFO_SIZE)
+		{
+			chip->fifoHead = (chip->fifoHead + 1) % SIM_RDS_FIFO_SIZE; // overrun: the oldest group is lost
+			chip->fifoCount--;
+			chip->groupLost = true;
+		}
+		tail = (chip->fifoHead + chip->fifoCount) % SIM_RDS_FIFO_SIZE;
+		memcpy(chip->fifo[tail], group, sizeof(chip->fifo[tail]));
+		chip->fifoBle[tail] = ble;
+		chip->fifoCount++;
+		if (chip->fifoCount >= (getProperty(SIM_FM_RDS_INT_FIFO_COUNT) ? getProperty(SIM_FM_RDS_INT_FIFO_COUNT) : 1))
+			chip->rdsRecv = true;
+	}
+	// Builds the n-th group broadcast by the station: 0A (PS and AF) and 2A (Radio Text) interleaved.
+	static void rdsBuildGroup(const sim_station *s, uint32_t n, uint16_t *group)
+	{
+		uint8_t rtSegments = (uint8_t)((strlen(s->rt) + 4) / 4); // +1 for the 0x0D terminator
+		if (rtSegments > 16)
+			rtSegments = 16;
+		group[0] = s->pi;
+		if ((n & 1) == 0)
+		{
+			uint8_t segment = (n / 2) % 4;
+			uint8_t pairs = 1 + s->afCount / 2;
+			uint8_t pair = (n / 8) % pairs;
+			uint8_t hi, lo;
+			group[1] = (uint16_t)((s->pty & 0x1F) << 5) | segment;
+			if (pair == 0)
+			{
+				hi = 224 + s->afCount;
+				lo = s->afCount ? s->af[0] : 205;
+			}
+			else
+			{
+				hi = s->af[pair * 2 - 1];
+				lo = (pair * 2 < s->afCount) ? s->af[pair * 2] : 205; // 205 = filler code
+			}
+			group[2] = (uint16_t)(hi << 8) | lo;
+			group[3] = (uint16_t)((uint8_t)(s->ps[segment * 2] ? s->ps[segment * 2] : ' ') << 8) | (uint8_t)(s->ps[segment * 2 + 1] ? s->ps[segment * 2 + 1] : ' ');
+		}
+		else
+		{
+			uint8_t segment = (n / 2) % rtSegments;
+			uint8_t c[4];
+			size_t len = strlen(s->rt);
+			for (uint8_t i = 0; i < 4; i++)
+			{
+				size_t k = segment * 4 + i;
+				c[i] = (k < len) ? s->rt[k] : ((k == len) ? 0x0D : ' ');
+			}
+			group[1] = 0x2000 | (uint16_t)((s->pty & 0x1F) << 5) | (s->rtAB ? 0x10 : 0) | segment;
+			group[2] = (uint16_t)(c[0] << 8) | c[1];
+			group[3] = (uint16_t)(c[2] << 8) | c[3];
+		}
+	}
+	// Moves the RDS groups received until now to the FIFO.
+	static void rdsUpdate(uint64_t now)
+	{
+		const sim_station *s;
+		uint16_t group[4];
+		uint8_t ble;
+		if (!chip->powered || !chip->fm || chip->station < 0 || chip->stcPending || !(getProperty(SIM_FM_RDS_CONFIG) & 1))
+			return;
+		s = &stations[chip->station];
+		if (s->pi == 0 || now < chip->rdsStart)
+			return;
+		while (chip->rdsGenerated <= (now - chip->rdsStart) / simTiming.rdsGroupUs)
+		{
+			rdsBuildGroup(s, chip->rdsGenerated++, group);
+			if (rdsReceive(group, &ble))
+				rdsPush(group, ble);
+		}
+	}
+
+	static uint8_t statusByte(uint64_t now)
+	{
+		uint8_t status = 0;
+		if (chip->stcPending && now >= chip->stcTime)
+		{
+			chip->stcPending = false;
+			chip->stcInt = true;
+			chip->rdsStart = chip->stcTime + 2 * (uint64_t)simTiming.rdsGroupUs; // RDS sync
+			chip->rdsGenerated = 0;
+		}
+		rdsUpdate(now);
+		if (now >= chip->ctsTime)
+			status |= SIM_CTS | chip->err;
+		if (chip->stcInt)
+			status |= SIM_STCINT;
+		if (chip->rdsRecv)
+			status |= SIM_RDSINT;
+		return status;
+	}
+
+	static sim_chip *findChip(uint16_t dev_addr)
+	{
+		for (uint8_t i = 0; i < SIM_MAX_CHIPS; i++)
+			if (chips[i].address && chips[i].address == dev_addr)
+				return &chips[i];
+		return NULL;
+	}
+
+	static void onTick(uint64_t now)
+	{
+		sim_chip *addressed = chip;
+		if (!interruptHandler)
+			return;
+		for (chip = chips; chip < chips + SIM_MAX_CHIPS; chip++)
+		{
+			bool notify = false;
+			if (!chip->address || !chip->powered)
+				continue;
+			if (chip->ctsIen && !chip->ctsNotified && now >= chip->ctsTime)
+			{
+				chip->ctsNotified = true;
+				notify = true;
+			}
+			if (chip->stcPending && now >= chip->stcTime && (getProperty(SIM_GPO_IEN) & 0x01))
+			{
+				statusByte(now);
+				notify = true;
+			}
+			if (notify)
+				interruptHandler(chip->intPin);
+		}
+		chip = addressed;
+	}
+
+	static uint16_t seekStep(uint16_t freq, bool up, bool *limit)
+	{
+		uint16_t bottom = getProperty(chip->fm ? SIM_FM_SEEK_BAND_BOTTOM : SIM_AM_SEEK_BAND_BOTTOM);
+		uint16_t top = getProperty(chip->fm ? SIM_FM_SEEK_BAND_TOP : SIM_AM_SEEK_BAND_TOP);
+		uint16_t spacing = getProperty(chip->fm ? SIM_FM_SEEK_FREQ_SPACING : SIM_AM_SEEK_FREQ_SPACING);
+		*limit = up ? (freq + spacing > top) : (freq < bottom + spacing);
+		if (*limit)
+			return up ? bottom : top;
+		return up ? freq + spacing : freq - spacing;
+	}
+	// Frequency the device is on now. While seeking it moves one channel every seekChannelUs.
+	static uint16_t frequencyNow(uint64_t now)
+	{
+		uint16_t freq = chip->seekFrom;
+		bool limit;
+		if (!chip->stcPending || !chip->seeking)
+			return chip->frequency;
+		for (uint64_t t = chip->stcTime; t > now + simTiming.seekChannelUs && freq != chip->frequency; t -= simTiming.seekChannelUs)
+			freq = seekStep(freq, chip->seekUp, &limit);
+		return freq;
+	}
+	static void startTune(uint16_t freq, uint32_t us)
+	{
+		uint8_t rssi, snr;
+		if (chip->stcPending)
+			chip->seekFrom = frequencyNow(simNow()); // a new tune aborts the current one
+		chip->seeking = false;
+		chip->frequency = freq;
+		chip->station = signalAt(freq, &rssi, &snr);
+		chip->stcPending = true;
+		chip->stcInt = false;
+		chip->bltf = false;
+		chip->stcTime = simNow() + us;
+		chip->fifoCount = chip->fifoHead = 0;
+		chip->groupLost = false;
+		simStats.tunes++;
+	}
+	static void startSeek(bool up, bool wrap)
+	{
+		uint16_t bottom = getProperty(chip->fm ? SIM_FM_SEEK_BAND_BOTTOM : SIM_AM_SEEK_BAND_BOTTOM);
+		uint16_t top = getProperty(chip->fm ? SIM_FM_SEEK_BAND_TOP : SIM_AM_SEEK_BAND_TOP);
+		uint16_t spacing = getProperty(chip->fm ? SIM_FM_SEEK_FREQ_SPACING : SIM_AM_SEEK_FREQ_SPACING);
+		uint16_t from = frequencyNow(simNow());
+		uint16_t freq = from;
+		uint32_t channels = 0, maxChannels = (top - bottom) / (spacing ? spacing : 1) + 1;
+		uint8_t rssi, snr;
+		bool found = false, limit = false;
+		while (channels < maxChannels)
+		{
+			channels++;
+			freq = seekStep(freq, up, &limit);
+			if (limit && !wrap)
+			{
+				freq = up ? top : bottom;
+				break;
+			}
+			signalAt(freq, &rssi, &snr);
+			if (isValid(rssi, snr))
+			{
+				found = true;
+				break;
+			}
+		}
+		if (!found && wrap)
+			freq = from;
+		startTune(freq, channels * simTiming.seekChannelUs);
+		chip->seeking = true;
+		chip->seekUp = up;
+		chip->seekFrom = from;
+		chip->bltf = !found;
+	}
+
+	static void tuneStatus(uint8_t arg)
+	{
+		uint8_t rssi = 0, snr = 0;
+		bool done = !chip->stcPending;
+		uint16_t freq = frequencyNow(simNow());
+		if (arg & 0x02) // CANCEL
+		{
+			chip->frequency = freq;
+			chip->stcPending = false;
+			chip->stcInt = true;
+			done = true;
+		}
+		if (done)
+			signalAt(chip->frequency, &rssi, &snr);
+		chip->response[1] = (done && isValid(rssi, snr) ? 0x01 : 0) | (done && chip->bltf ? 0x80 : 0);
+		chip->response[2] = freq >> 8;
+		chip->response[3] = freq & 0xFF;
+		chip->response[4] = rssi;
+		chip->response[5] = snr;
+		chip->response[6] = 0;
+		chip->response[7] = chip->fm ? 0 : 1;
+		chip->responseSize = 8;
+		if (arg & 0x01) // INTACK
+			chip->stcInt = false;
+	}
+	static void rsqStatus(void)
+	{
+		uint8_t rssi, snr;
+		signalAt(chip->frequency, &rssi, &snr);
+		chip->response[1] = 0;
+		chip->response[2] = isValid(rssi, snr) ? 0x01 : 0;
+		chip->response[3] = (chip->fm && rssi > 30) ? 0x80 | 100 : 0;
+		chip->response[4] = rssi;
+		chip->response[5] = snr;
+		chip->response[6] = 0;
+		chip->response[7] = 0;
+		chip->responseSize = 8;
+	}
+	// RDSFIFOUSED counts the group returned by this command (0 = the blocks are not valid).
+	static void rdsStatus(uint8_t arg)
+	{
+		uint8_t used = chip->fifoCount;
+		if (arg & 0x02) // MTFIFO
+			chip->fifoCount = chip->fifoHead = 0;
+		if (!(arg & 0x04) && chip->fifoCount) // STATUSONLY = 0: removes the oldest group
+		{
+			memcpy(chip->lastGroup, chip->fifo[chip->fifoHead], sizeof(chip->lastGroup));
+			chip->lastBle = chip->fifoBle[chip->fifoHead];
+			chip->fifoHead = (chip->fifoHead + 1) % SIM_RDS_FIFO_SIZE;
+			chip->fifoCount--;
+			simStats.rdsGroups++;
+		}
+		memset(&chip->response[1], 0, 12);
+		chip->response[1] = chip->rdsRecv ? 0x01 : 0; // RDSRECV (latched: it stays set on an empty FIFO until INTACK)
+		chip->response[2] = (chip->station >= 0 && stations[chip->station].pi && simNow() >= chip->rdsStart && !chip->stcPending ? 0x01 : 0) | (chip->groupLost ? 0x04 : 0);
+		chip->response[3] = used;
+		for (uint8_t i = 0; i < 4; i++)
+		{
+			chip->response[4 + i * 2] = chip->lastGroup[i] >> 8;
+			chip->response[5 + i * 2] = chip->lastGroup[i] & 0xFF;
+		}
+		chip->response[12] = chip->lastBle;
+		chip->responseSize = 13;
+		if (arg & 0x01)
+			chip->groupLost = chip->rdsRecv = false;
+	}
+
+	static void execute(const uint8_t *data, size_t len)
+	{
+		uint64_t now = simNow();
+		uint32_t busy = simTiming.commandUs;
+
+		chip->err = 0;
+		chip->responseSize = 1;
+		memset(chip->response, 0, sizeof(chip->response));
+		simStats.commands++;
+
+		if (chip->patchMode && (data[0] == SIM_PATCH_ARGS || data[0] == SIM_PATCH_DATA))
+		{
+			if (chip->patchLine++ == patchErrorAt)
+				chip->err = SIM_ERR;
+			for (size_t i = 0; i < len; i++)
+				chip->patchId = (uint16_t)(chip->patchId * 31 + data[i]);
+			if (data[0] == SIM_PATCH_ARGS && len == 8 && !data[1] && !data[2] && !data[3] && !data[4] && !data[5])
+				chip->patchRevId = (uint16_t)(data[6] << 8 | data[7]);
+			chip->patchRamId = chip->patchId;
+			chip->patchRamRevId = chip->patchRevId;
+			simStats.patchLines++;
+			busy = simTiming.patchLineUs;
+		}
+		else if (data[0] == SIM_POWER_UP && len >= 3)
+		{
+			uint8_t func = data[1] & 0x0F;
+			chip->patchMode = (data[1] & 0x20) != 0;
+			chip->ctsIen = (data[1] & 0x80) != 0;
+			if (func == 15) // Query library ID
+			{
+				chip->response[1] = 0x23;
+				chip->response[2] = '6';
+				chip->response[3] = '0';
+				chip->response[6] = 'D';
+				chip->response[7] = 4;
+				chip->responseSize = 8;
+			}
+			else
+			{
+				if (chip->patchMode)
+					chip->patchId = chip->patchLine = chip->patchRevId = chip->patchRamId = chip->patchRamRevId = 0;
+				else if (func == 1 && patchRetention)
+				{ // Boots the AM firmware with the patch still in RAM
+					chip->patchId = chip->patchRamId;
+					chip->patchRevId = chip->patchRamRevId;
+				}
+				else
+					chip->patchRamId = chip->patchRamRevId = 0;
+				chip->powered = true;
+				chip->fm = (func == 0);
+			}
+			busy = simTiming.powerUpUs;
+		}
+		else if (!chip->powered)
+			chip->err = SIM_ERR;
+		else
+		{
+			chip->patchMode = false;
+			switch (data[0])
+			{
+			case SIM_GET_REV:
+				chip->response[1] = 0x23; // Si4735
+				chip->response[2] = '6';
+				chip->response[3] = '0';
+				chip->response[4] = chip->patchRevId >> 8;
+				chip->response[5] = chip->patchRevId & 0xFF;
+				chip->response[6] = '6';
+				chip->response[7] = '0';
+				chip->response[8] = 'D';
+				chip->responseSize = 9;
+				break;
+			case SIM_POWER_DOWN:
+				powerDown();
+				break;
+			case SIM_SET_PROPERTY:
+				if (len < 6 || !setProperty((uint16_t)(data[2] << 8 | data[3]), (uint16_t)(data[4] << 8 | data[5])))
+					chip->err = SIM_ERR;
+				simStats.properties++;
+				busy = simTiming.propertyUs;
+				break;
+			case SIM_GET_PROPERTY:
+			{
+				uint16_t value = getProperty((uint16_t)(data[2] << 8 | data[3]));
+				chip->response[2] = value >> 8;
+				chip->response[3] = value & 0xFF;
+				chip->responseSize = 4;
+				busy = simTiming.propertyUs;
+				break;
+			}
+			case SIM_GET_INT_STATUS:
+				break;
+			case SIM_FM_TUNE_FREQ:
+			case SIM_NBFM_TUNE_FREQ:
+			case SIM_AM_TUNE_FREQ:
+				if (len < 4 || (data[0] == SIM_AM_TUNE_FREQ) == chip->fm)
+					chip->err = SIM_ERR;
+				else
+					startTune((uint16_t)(data[2] << 8 | data[3]), chip->fm ? simTiming.fmTuneUs : simTiming.amTuneUs);
+				break;
+			case SIM_FM_SEEK_START:
+			case SIM_AM_SEEK_START:
+				if (len < 2 || (data[0] == SIM_AM_SEEK_START) == chip->fm)
+					chip->err = SIM_ERR;
+				else
+					startSeek((data[1] & 0x08) != 0, (data[1] & 0x04) != 0);
+				break;
+			case SIM_FM_TUNE_STATUS:
+			case SIM_AM_TUNE_STATUS:
+			case SIM_NBFM_TUNE_STATUS:
+				statusByte(now);
+				tuneStatus(len > 1 ? data[1] : 0);
+				break;
+			case SIM_FM_RSQ_STATUS:
+			case SIM_AM_RSQ_STATUS:
+			case SIM_NBFM_RSQ_STATUS:
+				rsqStatus();
+				break;
+			case SIM_FM_RDS_STATUS:
+				if (!chip->fm)
+					chip->err = SIM_ERR;
+				else
+				{
+					statusByte(now);
+					rdsStatus(len > 1 ? data[1] : 0);
+				}
+				break;
+			default:
+				// Other commands (AGC, GPIO, SSB etc.) are accepted and answered with zeros.
+				chip->responseSize = 8;
+				break;
+			}
+		}
+		if (chip->err)
+			simStats.errors++;
+		chip->ctsTime = now + busy;
+		chip->ctsNotified = false;
+	}
+
+	static void onWrite(const uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		if (eepromContent && dev_addr == eepromAddress && len >= 2)
+			eepromPointer = (uint16_t)(data[0] << 8 | data[1]); // Address write (the content is read only)
+		if (!findChip(dev_addr) || len == 0)
+			return;
+		chip = findChip(dev_addr);
+		if (simNow() < chip->ctsTime)
+			simStats.busyWrites++;
+		execute(data, len);
+	}
+	static void onRead(uint8_t *data, size_t len, uint16_t dev_addr)
+	{
+		uint64_t now = simNow();
+		uint8_t status;
+		if (eepromContent && dev_addr == eepromAddress)
+		{ // Sequential read from the current address
+			for (size_t i = 0; i < len; i++, eepromPointer++)
+				data[i] = eepromPointer < eepromSize ? eepromContent[eepromPointer] : 0xFF;
+			return;
+		}
+		if (!findChip(dev_addr))
+		{
+			memset(data, 0xFF, len); // nobody on the bus
+			return;
+		}
+		chip = findChip(dev_addr);
+		simStats.statusReads++;
+		status = statusByte(now);
+		memset(data, 0, len);
+		if (!(status & SIM_CTS))
+		{
+			simStats.busyReads++;
+			data[0] = status;
+			return;
+		}
+		memcpy(data, chip->response, len < sizeof(chip->response) ? len : sizeof(chip->response));
+		data[0] = status;
+	}
+	static void onGpio(uint8_t pin, bool value)
+	{
+		sim_chip *addressed = chip;
+		if (value)
+			return;
+		for (chip = chips; chip < chips + SIM_MAX_CHIPS; chip++)
+			if (chip->address && chip->resetPin == pin)
+			{
+				powerDown();
+				chip->patchRamId = chip->patchRamRevId = 0;
+			}
+		chip = addressed;
+	}
+
+	static const fake_device_model simModel = {onWrite, onRead, onGpio, onTick};
+
+	void simInit(void)
+	{
+		simTiming.powerUpUs = 110000;
+		simTiming.commandUs = 300;
+		simTiming.propertyUs = 550;
+		simTiming.patchLineUs = 150;
+		simTiming.fmTuneUs = 60000;
+		simTiming.amTuneUs = 80000;
+		simTiming.seekChannelUs = 30000;
+		simTiming.rdsGroupUs = 87600;
+		memset(&simStats, 0, sizeof(simStats));
+		patchErrorAt = -1;
+		patchRetention = false;
+		rdsErrorPercent = 0;
+		rdsErrorSeed = 1;
+		eepromContent = NULL;
+		simClearStations();
+		for (uint8_t i = 0; i < sizeof(defaultStations) / sizeof(defaultStations[0]); i++)
+			simAddStation(&defaultStations[i]);
+		memset(chips, 0, sizeof(chips));
+		for (chip = chips; chip < chips + SIM_MAX_CHIPS; chip++)
+			powerDown();
+		chip = &chips[0];
+		chip->address = 0x11;
+		chip->resetPin = SI473X_GPIO_RESET;
+		chip->intPin = GPIO_SI473X_PIN_INT;
+		fakeTransportReset();
+		fakeTransportAttach(&simModel);
+	}
+	void simClearStations(void)
+	{
+		stationCount = 0;
+	}
+	bool simAddStation(const sim_station *station)
+	{
+		if (stationCount == SIM_MAX_STATIONS)
+			return false;
+		stations[stationCount++] = *station;
+		return true;
+	}
+	void simSetInterruptHandler(void (*handler)(uint16_t pin))
+	{
+		interruptHandler = handler;
+	}
+	void simSetSenHigh(bool high)
+	{
+		chips[0].address = high ? 0x63 : 0x11;
+	}
+	bool simAddChip(uint16_t address, uint8_t resetPin, uint16_t intPin)
+	{
+		for (uint8_t i = 1; i < SIM_MAX_CHIPS; i++)
+			if (!chips[i].address)
+			{
+				chips[i].address = address;
+				chips[i].resetPin = resetPin;
+				chips[i].intPin = intPin;
+				return true;
+			}
+		return false;
+	}
+	bool simSelectChip(uint16_t address)
+	{
+		if (!findChip(address))
+			return false;
+		chip = findChip(address);
+		return true;
+	}
+	void simInjectRdsGroup(uint16_t blockA, uint16_t blockB, uint16_t blockC, uint16_t blockD)
+	{
+		uint16_t group[4] = {blockA, blockB, blockC, blockD};
+		rdsPush(group, 0);
+	}
+	void simSetRdsBlockErrors(uint8_t percent)
+	{
+		rdsErrorPercent = percent;
+	}
+	bool simIsPoweredUp(void)
+	{
+		return chip->powered;
+	}
+	uint16_t simGetFrequency(void)
+	{
+		return chip->frequency;
+	}
+	uint16_t simGetProperty(uint16_t property)
+	{
+		return getProperty(property);
+	}
+	uint16_t simGetPatchId(void)
+	{
+		return chip->patchId;
+	}
+	void simInjectPatchError(int32_t line)
+	{
+		patchErrorAt = line;
+	}
+	void simSetPatchRetention(bool retained)
+	{
+		patchRetention = retained;
+	}
+	void simAttachEeprom(uint16_t address, const uint8_t *content, size_t size)
+	{
+		eepromAddress = address;
+		eepromContent = content;
+		eepromSize = size;
+		eepromPointer = 0;
+	}
+#endif
\ No newline at end of file
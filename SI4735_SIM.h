@@ -0,0 +1,90 @@
+#ifndef _SI4735_SIM_H_
+#define _SI4735_SIM_H_
+
+// Behavioral model of the SI473X used on a PC (build with SI473X_HOST).
+// It is attached to fakeTransport and answers the commands issued by SI4735.c with the
+// CTS/STC timing of the real device and a synthetic band of stations (including RDS).
+//
+// Usage (gcc -DSI473X_HOST SI4735.c SI4735_HAL_FAKE.c SI4735_SIM.c app.c; see "make test"):
+//   simInit();                          // attaches the model to fakeTransport
+//   setup(0);                           // FM
+//   setFM(8400, 10800, 10390, 10);
+//   printf("%u us, %u bytes, %u busy reads\n", (unsigned)fakeTransportMicros(), fakeBytesOnBus, simStats.busyReads);
+
+#include "SI4735_HAL.h"
+
+#define SIM_MAX_STATIONS 32
+#define SIM_MAX_PROPERTIES 96
+#define SIM_RDS_FIFO_SIZE 25 // Groups kept by the RDS FIFO of the device
+#define SIM_MAX_AF 8
+#define SIM_MAX_CHIPS 2 // Devices on the bus (see simAddChip)
+
+/**
+ * @brief A station of the synthetic band.
+ */
+typedef struct
+{
+	uint16_t frequency;    // FM: 10 kHz units (10390 = 103.9 MHz); AM: kHz
+	bool fm;               // true = FM station; false = AM station
+	uint8_t rssi;          // dBuV at the exact frequency
+	uint8_t snr;           // dB at the exact frequency
+	uint16_t pi;           // RDS Program Identification (0 = no RDS)
+	uint8_t pty;           // RDS Program Type
+	bool rtAB;             // RDS Radio Text A/B flag
+	char ps[9];            // RDS Program Service name
+	char rt[65];           // RDS Radio Text
+	uint8_t af[SIM_MAX_AF]; // RDS Alternative Frequency codes (frequency = 8750 + code * 10)
+	uint8_t afCount;
+} sim_station;
+
+/**
+ * @brief Time (in us) the device takes to execute each kind of command.
+ */
+typedef struct
+{
+	uint32_t powerUpUs;     // POWER_UP (crystal oscillator start up)
+	uint32_t commandUs;     // Any other command until CTS
+	uint32_t propertyUs;    // SET_PROPERTY / GET_PROPERTY
+	uint32_t patchLineUs;   // Each 8 bytes patch line (0x15/0x16)
+	uint32_t fmTuneUs;      // FM_TUNE_FREQ until STC
+	uint32_t amTuneUs;      // AM_TUNE_FREQ until STC
+	uint32_t seekChannelUs; // Each channel visited by a seek
+	uint32_t rdsGroupUs;    // Time between RDS groups (1187.5 bps / 104 bits)
+} sim_timing;
+
+/**
+ * @brief What the driver asked to the device. Reset by simInit.
+ */
+typedef struct
+{
+	uint32_t commands;     // Commands executed
+	uint32_t properties;   // SET_PROPERTY commands
+	uint32_t tunes;        // Tune and seek commands
+	uint32_t statusReads;  // Read transactions
+	uint32_t busyReads;    // Reads done while CTS was 0 (polling cost)
+	uint32_t busyWrites;   // Commands sent while CTS was 0 (driver bug)
+	uint32_t patchLines;   // Patch lines received
+	uint32_t rdsGroups;    // RDS groups delivered to the driver
+	uint32_t errors;       // Commands answered with ERR
+} sim_stats;
+
+extern sim_timing simTiming;
+extern sim_stats simStats;
+
+	void simInit(void);
+	void simClearStations(void);
+	bool simAddStation(const sim_station *station);
+	void simSetInterruptHandler(void (*handler)(uint16_t pin));
+	void simSetSenHigh(bool high);
+	bool simAddChip(uint16_t address, uint8_t resetPin, uint16_t intPin); // Another device on the bus (same stations); resetPin = gpioWrite pin of its RST line; intPin is passed to the interrupt handler
+	bool simSelectChip(uint16_t address); // Device reported by simGetFrequency, simGetProperty, ... (default: the last one addressed by the driver)
+	void simInjectRdsGroup(uint16_t blockA, uint16_t blockB, uint16_t blockC, uint16_t blockD);
+	void simSetRdsBlockErrors(uint8_t percent); // Blocks received with errors: BLE 1 corrected, BLE 2 may carry a wrong bit, BLE 3 garbage (default 0)
+	bool simIsPoweredUp(void);
+	uint16_t simGetFrequency(void);
+	uint16_t simGetProperty(uint16_t property);
+	uint16_t simGetPatchId(void);
+	void simInjectPatchError(int32_t line); // The patch line (0 = first) will be answered with ERR; -1 = none
+	void simSetPatchRetention(bool retained); // true = the patch survives POWER_DOWN and an AM POWER_UP without PATCH runs it (default false)
+	void simAttachEeprom(uint16_t address, const uint8_t *content, size_t size); // 24Cxx EEPROM (2 bytes address) holding content
+#endif // _SI4735_SIM_H_
\ No newline at end of file
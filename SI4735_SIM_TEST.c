@@ -0,0 +1,549 @@
+#include <stdio.h>
+#include <string.h>
+#include "SI4735.h"
+#include "SI4735_SIM.h"
+#define ssb_patch_content ssb_patch_compressed // patch_init.h is built into SI4735.c
+#include "patch_ssb_compressed.h"
+#undef ssb_patch_content
+
+// Host checks and benchmark of the driver against the simulator (make test).
+// Times are virtual (fakeTransport clock), so the results are the same on any PC.
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	printf("%-48s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+static uint32_t elapsedUs(uint64_t start)
+{
+	return (uint32_t)(fakeTransportMicros() - start);
+}
+static void testTune(void)
+{
+	uint64_t start;
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	check(getFrequency() == 10390 && simGetFrequency() == 10390, "FM tune to 103.9 MHz");
+	start = fakeTransportMicros();
+	simStats.commands = 0;
+	for (uint8_t i = 0; i < 10; i++)
+		setFrequency(i & 1 ? 10010 : 10390);
+	check(simGetFrequency() == 10010, "10 tunes between two stations");
+	printf("  %u us per tune, %u commands\n", (unsigned)(elapsedUs(start) / 10), (unsigned)simStats.commands);
+	check(simStats.busyWrites == 0, "no command sent before CTS");
+}
+static void testScan(void)
+{
+	si473x_scan_entry stations[16];
+	uint16_t count;
+	uint64_t start;
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 8750, 10);
+	start = fakeTransportMicros();
+	count = scanBand(stations, 16, 0, NULL);
+	check(count == 6 && stations[0].frequency == 10390, "FM band scan finds 6 stations (best first)");
+	printf("  scan: %u ms\n", (unsigned)(elapsedUs(start) / 1000));
+}
+static void testAmScan(void)
+{
+	static const sim_station am[] = {
+		{1000, false, 40, 20, 0, 0, false, "", "", {}, 0},
+		{1010, false, 36, 18, 0, 0, false, "", "", {}, 0}
+	};
+	si473x_scan_entry stations[16];
+	uint16_t count;
+	simInit();
+	simClearStations();
+	simAddStation(&am[0]);
+	simAddStation(&am[1]);
+	setup(POWER_UP_FM);
+	setAM(520, 1710, 810, 10);
+	count = scanBand(stations, 16, 0, NULL);
+	check(count == 2 && stations[0].frequency == 1000 && stations[1].frequency == 1010, "AM band scan keeps stations 10 kHz apart");
+}
+static void testSeek(void)
+{
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 8810, 10);
+	seekNextStation();
+	check(!isTuneComplete(), "seekNextStation clears STCINT");
+	seekStationProgress(NULL, 1);
+	check(!isTuneComplete() && currentWorkFrequency == simGetFrequency(), "seekStationProgress clears STCINT");
+}
+static void testRds(void)
+{
+	uint16_t updates;
+	uint32_t ms;
+	simInit();
+	simSetRdsBlockErrors(10);
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	setRdsConfig(1, 2, 2, 2, 2);
+	for (ms = 0; ms < 10000 && !isRdsStationNameComplete(); ms += 40)
+	{
+		fakeTransportAdvance(40000);
+		drainRdsFifo(&updates);
+	}
+	check(rdsInfo.pi == 0xE505, "RDS PI with 10% block errors");
+	check(strcmp(rds_buffer0A, "ROCK FM ") == 0, "RDS PS with 10% block errors");
+	printf("  PS complete after %u ms, %u groups\n", (unsigned)ms, (unsigned)simStats.rdsGroups);
+}
+static void testRdsFastPoll(void)
+{
+	uint16_t wrong = 0;
+	char *ps;
+	simInit();
+	simSetRdsBlockErrors(15);
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	setRdsConfig(1, 3, 3, 3, 3);
+	for (uint32_t ms = 0; ms < 20000; ms++) // Much faster than the groups: most polls find the FIFO empty
+	{
+		fakeTransportAdvance(1000);
+		getRdsStatus();
+		if ((ps = getRdsText0A()) == NULL)
+			continue;
+		for (uint8_t i = 0; i < 8; i++)
+			if (ps[i] && ps[i] != "ROCK FM "[i])
+			{
+				wrong++;
+				break;
+			}
+	}
+	check(wrong == 0 && strcmp(rds_buffer0A, "ROCK FM ") == 0, "getRdsText0A polled every 1 ms: no wrong PS");
+}
+static uint16_t lzLength(uint8_t *out, uint16_t n, uint32_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		out[n++] = (uint8_t)(value | 0x80);
+	out[n++] = (uint8_t)value;
+	return n;
+}
+// Same container as tools/patch_lz.py (greedy matches in a 255 bytes window)
+static uint16_t lzPack(const uint8_t *patch, uint16_t size, uint8_t *out)
+{
+	static uint8_t content[10 * 1024];
+	uint16_t lines = size / 8, count = 0, last = 0, n = 5, literals = 0, i = 0, len, used;
+	for (uint16_t l = 0; l < lines; l++)
+		memcpy(&content[l * 7], &patch[l * 8 + 1], 7);
+	for (uint16_t l = 0; l < lines; l++)
+		if (patch[l * 8] == 0x15)
+		{
+			n = lzLength(out, n, l - last);
+			last = l;
+			count++;
+		}
+	out[0] = 1;
+	out[1] = lines & 0xFF;
+	out[2] = lines >> 8;
+	out[3] = count & 0xFF;
+	out[4] = count >> 8;
+	len = lines * 7;
+	while (i <= len)
+	{
+		uint16_t best = 0, offset = 0;
+		for (uint16_t j = (i > 255 ? i - 255 : 0); i < len && j < i; j++)
+		{
+			uint16_t m = 0;
+			while (i + m < len && content[j + m] == content[i + m])
+				m++;
+			if (m > best)
+			{
+				best = m;
+				offset = i - j;
+			}
+		}
+		if (best < 3 && i < len)
+		{
+			literals++;
+			i++;
+			continue;
+		}
+		used = i >= len ? 0 : best - 3;
+		out[n++] = (uint8_t)((literals < 15 ? literals : 15) << 4 | (used < 15 ? used : 15));
+		if (literals >= 15)
+			n = lzLength(out, n, literals - 15);
+		memcpy(&out[n], &content[i - literals], literals);
+		n += literals;
+		literals = 0;
+		if (i >= len)
+			break;
+		out[n++] = (uint8_t)offset;
+		if (used >= 15)
+			n = lzLength(out, n, used - 15);
+		i += best;
+	}
+	return n;
+}
+static void testPatch(void)
+{
+	static uint8_t bad[10 * 1024], lz[10 * 1024], eeprom[32 + 10 * 1024];
+	si4735_eeprom_patch_header header;
+	si473x_patch_result r;
+	uint16_t lzSize;
+	uint32_t lines;
+	simInit();
+	setup(POWER_UP_AM);
+	queryLibraryId();
+	patchPowerUp();
+	r = downloadPatchChecked(ssb_patch_content, size_content, ssb_patch_crc);
+	check(r.status == PATCH_RESULT_OK && simGetPatchId() != 0, "patch download (CTS checked)");
+	check(simStats.busyWrites == 0, "patch: no line sent before CTS");
+	memcpy(bad, ssb_patch_content, size_content);
+	bad[777] ^= 1;
+	lines = simStats.patchLines;
+	r = downloadPatchChecked(bad, size_content, ssb_patch_crc);
+	check(r.status == PATCH_RESULT_CRC_MISMATCH && simStats.patchLines == lines, "corrupt patch rejected by CRC (nothing sent)");
+	simInjectPatchError(42);
+	queryLibraryId();
+	patchPowerUp();
+	r = downloadPatchChecked(ssb_patch_content, size_content, ssb_patch_crc);
+	check(r.status == PATCH_RESULT_CHIP_ERR && r.line == 42, "line rejected by the device reported");
+	simInjectPatchError(-1);
+
+	queryLibraryId();
+	patchPowerUp();
+	r = downloadCompressedPatchChecked(ssb_patch_compressed, sizeof ssb_patch_compressed, cmd_0x15, sizeof cmd_0x15, ssb_patch_crc);
+	check(r.status == PATCH_RESULT_OK && simGetPatchId() != 0, "compressed patch download (CRC of the patch)");
+	r = downloadCompressedPatchChecked(ssb_patch_compressed, sizeof ssb_patch_compressed, cmd_0x15, sizeof cmd_0x15 - 2, ssb_patch_crc);
+	check(r.status == PATCH_RESULT_CRC_MISMATCH, "compressed patch: wrong 0x15 table rejected");
+
+	lzSize = lzPack(ssb_patch_content, size_content, lz);
+	queryLibraryId();
+	patchPowerUp();
+	r = downloadLzPatchChecked(lz, lzSize, patchCrc16(lz, lzSize));
+	check(r.status == PATCH_RESULT_OK && simGetPatchId() != 0, "LZ patch download");
+	printf("  LZ patch: %u of %u bytes\n", (unsigned)lzSize, (unsigned)size_content);
+	lz[0] = 9;
+	r = downloadLzPatchChecked(lz, lzSize, patchCrc16(lz, lzSize));
+	check(r.status == PATCH_RESULT_FORMAT_ERR, "unknown LZ container rejected");
+
+	memset(&header, 0, sizeof(header));
+	strcpy((char *)header.refined.patch_id, "SSB_INIT");
+	header.refined.patch_size = size_content;
+	memcpy(eeprom, header.raw, 32);
+	memcpy(eeprom + 32, ssb_patch_content, size_content);
+	simAttachEeprom(0x50, eeprom, 32 + size_content);
+	queryLibraryId();
+	patchPowerUp();
+	header = downloadPatchFromEeprom(0x50);
+	check(patchResult.status == PATCH_RESULT_OK && simGetPatchId() != 0 && strcmp((char *)header.refined.patch_id, "SSB_INIT") == 0, "patch streamed from the EEPROM");
+	printf("  EEPROM: %u bytes/s\n", (unsigned)getEepromPatchThroughput());
+	simInjectPatchError(500);
+	queryLibraryId();
+	patchPowerUp();
+	downloadPatchFromEeprom(0x50);
+	check(patchResult.status == PATCH_RESULT_CHIP_ERR && getPatchErrorLine() == 500, "EEPROM line rejected by the device reported");
+	simInjectPatchError(-1);
+	check(simStats.busyWrites == 0, "patch downloads: no line sent before CTS");
+}
+static void testResidentPatch(void)
+{
+	uint32_t lines;
+	uint64_t start;
+	simInit();
+	simSetPatchRetention(true);
+	setPatchRetention(true);
+	setup(POWER_UP_AM);
+	loadPatch(ssb_patch_content, size_content, 0);
+	check(isPatchResident(ssb_patch_content), "patch resident after loadPatch");
+	setSSB_t(7000, 7300, 7100, 1, 1);
+	lines = simStats.patchLines;
+	start = fakeTransportMicros();
+	loadPatch(ssb_patch_content, size_content, 0);
+	check(simStats.patchLines == lines && simGetPatchId() != 0, "reload skipped while the device holds the patch");
+	printf("  reload: %u ms\n", (unsigned)(elapsedUs(start) / 1000));
+	simSetPatchRetention(false);
+	setSSB_t(7000, 7300, 7100, 1, 1);
+	loadPatch(ssb_patch_content, size_content, 0);
+	check(simStats.patchLines > lines && simGetPatchId() != 0, "patch downloaded again when the device lost it");
+	setPatchRetention(false);
+	setSSB_t(7000, 7300, 7100, 1, 1);
+	lines = simStats.patchLines;
+	start = fakeTransportMicros();
+	loadPatch(ssb_patch_content, size_content, 0);
+	check(simStats.patchLines > lines && simGetPatchId() != 0, "no retention: patch downloaded without a check");
+	printf("  download: %u ms\n", (unsigned)(elapsedUs(start) / 1000));
+}
+static void testProperties(void)
+{
+	uint32_t sent;
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	setVolume(20);
+	sent = simStats.properties;
+	setVolume(20);
+	check(simStats.properties == sent, "property cache skips a value already sent");
+	setVolume(40);
+	check(simStats.properties == sent + 1 && simGetProperty(0x4000) == 40, "property cache sends a new value");
+	invalidateCachedProperty(0x4000);
+	check(getCachedProperty(0x4000) == -1 && getCachedProperty(SI473X_ALL_PROPERTIES) == -1, "invalidated cache entry is free");
+	setVolume(40);
+	check(simStats.properties == sent + 2 && getCachedProperty(0x4000) == 40, "freed cache entry reused");
+	beginProperties();
+	addProperty(0x4000, 50);
+	addProperty(0x1105, 2);
+	addProperty(0x1108, 25);
+	check(commitProperties() == -1, "property batch accepted");
+	check(simGetProperty(0x4000) == 50 && simGetProperty(0x1105) == 2 && simGetProperty(0x1108) == 25, "property batch applied");
+	beginProperties();
+	setVolume(10);
+	check(getProperty(0x4000) == 10 && simGetProperty(0x4000) == 50, "getProperty answers from the open batch");
+	commitProperties();
+	check(getProperty(0x4000) == 10 && simGetProperty(0x4000) == 10, "getProperty after the commit");
+	check(simStats.busyWrites == 0 && simStats.errors == 0, "property batch: no command sent before CTS");
+}
+static void testInterrupt(void)
+{
+	uint32_t commands;
+	simInit();
+	simSetInterruptHandler(SI4735_EXTI_Callback);
+	reset();
+	setup_t(1, 0, SI473X_ANALOG_AUDIO, XOSCEN_CRYSTAL, 1);
+	setCtsWaitMode(CTS_WAIT_INTERRUPT);
+	setFM(8400, 10800, 10390, 10);
+	setGpioIen(1, 0, 0, 1, 0, 0);
+	commands = simStats.commands;
+	setFrequency(10010);
+	check(simGetFrequency() == 10010 && simStats.busyWrites == 0, "tune with CTS and STC interrupts");
+	printf("  %u commands per tune\n", (unsigned)(simStats.commands - commands));
+	setGpioIen(0, 0, 0, 0, 0, 0);
+	setCtsWaitMode(CTS_WAIT_POLLING);
+	simSetInterruptHandler(NULL);
+}
+static void testBackgroundScan(void)
+{
+	static si473x_station_db db;
+	const si473x_station_record *best;
+	uint32_t ms;
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 9130, 10);
+	setRdsConfig(1, 3, 3, 3, 3);
+	startBackgroundScan(&db, SCAN_RDS_WINDOW);
+	for (ms = 0; ms < 120000 && db.cycles == 0; ms += 2)
+	{
+		processBackgroundScan(&db);
+		fakeTransportAdvance(2000);
+	}
+	best = getBestStation(&db, 0);
+	check(db.cycles == 1 && getStationCount(&db) == 6, "background scan finds 6 stations");
+	check(best != NULL && best->frequency == 10390 && strcmp(best->ps, "ROCK FM ") == 0, "background scan: best station and its PS");
+	printf("  one pass: %u ms\n", (unsigned)ms);
+	stopBackgroundScan(&db);
+	check(simGetFrequency() == 9130, "background scan restores the frequency");
+}
+static char rdsText[65];
+static uint8_t rdsTextEvents;
+static void onRdsText(const char *text, uint8_t versionCode, uint8_t textAB)
+{
+	(void)versionCode;
+	(void)textAB;
+	strcpy(rdsText, text);
+	rdsTextEvents++;
+}
+static void testRdsText(void)
+{
+	uint16_t updates;
+	simInit();
+	simSetRdsBlockErrors(5);
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	setRdsConfig(1, 3, 3, 3, 3);
+	rdsTextEvents = 0;
+	setRdsTextHandler(onRdsText);
+	for (uint32_t ms = 0; ms < 10000 && rdsTextEvents == 0; ms += 40)
+	{
+		fakeTransportAdvance(40000);
+		drainRdsFifo(&updates);
+	}
+	check(rdsTextEvents == 1 && strncmp(rdsText, "Rock around the clock", 21) == 0, "RadioText published once complete");
+	setFrequency(10010);
+	for (uint32_t ms = 0; ms < 10000 && rdsTextEvents == 1; ms += 40)
+	{
+		fakeTransportAdvance(40000);
+		drainRdsFifo(&updates);
+	}
+	check(rdsTextEvents == 2 && strncmp(rdsText, "Now playing: the top 40", 23) == 0, "RadioText of the next station");
+	setRdsTextHandler(NULL);
+}
+static uint32_t waitRdsStation(uint16_t *flags)
+{
+	uint16_t updates;
+	uint32_t ms;
+	*flags = 0;
+	for (ms = 20; ms < 10000; ms += 20)
+	{
+		fakeTransportAdvance(20000);
+		drainRdsFifo(&updates);
+		*flags |= updates;
+		if (isRdsStationNameComplete() && rds_buffer2A[0])
+			break;
+	}
+	return ms;
+}
+static void testRdsCache(void)
+{
+	uint16_t flags;
+	uint32_t first, back;
+	simInit();
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10390, 10);
+	setRdsConfig(1, 3, 3, 3, 3);
+	setRdsCache(true);
+	clearRdsCache();
+	first = waitRdsStation(&flags);
+	setFrequency(10010);
+	waitRdsStation(&flags);
+	setFrequency(10390);
+	back = waitRdsStation(&flags);
+	check((flags & RDS_NEW_CACHED) && back < first && strcmp(rds_buffer0A, "ROCK FM ") == 0, "station cache recalls PS and RT after a retune");
+	printf("  PS and RT: %u ms first time, %u ms back\n", (unsigned)first, (unsigned)back);
+	setRdsCache(false);
+}
+static uint16_t runAfSwitch(si473x_af_switch *af, uint16_t altPi, uint32_t ms)
+{
+	sim_station home = {9000, true, 18, 6, 0xE777, 5, false, "HOME FM", "Same program everywhere", {105, 75}, 2};
+	sim_station other = {9800, true, 55, 30, 0xE888, 5, false, "OTHER", "x", {0}, 0};
+	sim_station alt = {9500, true, 45, 25, altPi, 5, false, "HOME FM", "Same program everywhere", {0}, 0};
+	uint16_t updates;
+	uint32_t tunes;
+	simInit();
+	simClearStations();
+	simAddStation(&home);
+	simAddStation(&other);
+	simAddStation(&alt);
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 9000, 10);
+	setRdsConfig(1, 3, 3, 3, 3);
+	tunes = simStats.tunes;
+	startAfSwitch(af, RDS_AF_MIN_RSSI, RDS_AF_MIN_SNR);
+	for (uint32_t t = 0; t < ms; t++) // processAfSwitch called every 1 ms, RDS drained every 20 ms
+	{
+		fakeTransportAdvance(1000);
+		if (t % 20 == 0)
+			drainRdsFifo(&updates);
+		processAfSwitch(af);
+	}
+	return (uint16_t)(simStats.tunes - tunes);
+}
+static void testAfSwitch(void)
+{
+	si473x_af_switch af;
+	uint16_t tunes;
+	runAfSwitch(&af, 0xE777, 12000);
+	check(af.switches == 1 && simGetFrequency() == 9500, "AF switch to the stronger AF with the same PI");
+	check(simGetProperty(0x4001) == 0, "AF switch unmutes the audio");
+	stopAfSwitch(&af);
+	tunes = runAfSwitch(&af, 0xE999, 60000);
+	check(af.switches == 0 && simGetFrequency() == 9000, "AF switch stays when no AF has the same PI");
+	check(tunes <= 20, "AF checks back off when no AF is better");
+	printf("  %u tunes in 60 s without a better AF\n", (unsigned)tunes);
+	stopAfSwitch(&af);
+}
+static void testCapture(void)
+{
+	static si473x_rds_capture capture;
+	static si473x_rds_raw_group groups[SI473X_RDS_CAPTURE_SIZE * 8];
+	char ps[9], rt[65], line[SI473X_RDS_GROUP_LINE];
+	si473x_rds_raw_group parsed;
+	uint16_t count = 0, updates;
+	bool same = true;
+	simInit();
+	simSetRdsBlockErrors(10);
+	setup(POWER_UP_FM);
+	setFM(8400, 10800, 10010, 10);
+	setRdsConfig(1, 2, 2, 2, 2);
+	startRdsCapture(&capture);
+	for (uint32_t ms = 0; ms < 30000 && count < SI473X_RDS_CAPTURE_SIZE * 8 - 16; ms += 50)
+	{
+		fakeTransportAdvance(50000);
+		drainRdsFifo(&updates);
+		count += readRdsCapture(&capture, &groups[count], 16);
+	}
+	startRdsCapture(NULL);
+	strcpy(ps, rds_buffer0A);
+	strcpy(rt, rds_buffer2A);
+	for (uint16_t i = 0; i < count && same; i++)
+	{
+		formatRdsGroup(&groups[i], line);
+		same = parseRdsGroup(line, &parsed) && memcmp(&parsed, &groups[i], sizeof(parsed)) == 0;
+	}
+	check(count > 0 && capture.dropped == 0 && same, "captured groups survive format and parse");
+	RdsInit();
+	for (uint16_t i = 0; i < count; i++)
+		replayRdsGroup(&groups[i]);
+	check(strcmp(ps, rds_buffer0A) == 0 && strcmp(rt, rds_buffer2A) == 0, "replay rebuilds the live PS and RT");
+}
+#ifdef SI473X_MULTI_DEVICE
+static void gpioSecond(uint8_t pin, bool value)
+{
+	fakeTransport.gpioWrite(pin == SI473X_GPIO_RESET ? 8 : pin, value);
+}
+static void testContexts(void)
+{
+	static si473x_transport transport;
+	static si473x_context second;
+	transport = fakeTransport;
+	transport.gpioWrite = gpioSecond;
+	simInit();
+	simAddChip(0x63, 8, 0x0020);
+	simSetInterruptHandler(SI4735_EXTI_Callback);
+	initContext(&second, &transport, SI473X_ADDR_SEN_HIGH, 0x0020);
+	setup_t(1, 0, SI473X_ANALOG_AUDIO, XOSCEN_CRYSTAL, 1);
+	setCtsWaitMode(CTS_WAIT_INTERRUPT);
+	setFM(8400, 10800, 10390, 10);
+	setVolume(20);
+	selectContext(&second);
+	setup_t(1, 0, SI473X_ANALOG_AUDIO, XOSCEN_CRYSTAL, 1);
+	setCtsWaitMode(CTS_WAIT_INTERRUPT);
+	setFM(8400, 10800, 8810, 10);
+	setVolume(50);
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		selectContext(i & 1 ? &second : NULL);
+		frequencyUp();
+	}
+	selectContext(&second);
+	check(getFrequency() == 8830 && currentWorkFrequency == 8830, "second context keeps its own state");
+	selectContext(NULL);
+	check(getFrequency() == 10410 && currentWorkFrequency == 10410, "first context keeps its own state");
+	simSelectChip(0x11);
+	check(simGetFrequency() == 10410 && simGetProperty(0x4000) == 20, "first device tuned by its context");
+	simSelectChip(0x63);
+	check(simGetFrequency() == 8830 && simGetProperty(0x4000) == 50, "second device tuned by its context");
+	check(simStats.busyWrites == 0 && simStats.errors == 0, "contexts: no command sent before CTS");
+	simSelectChip(0x11);
+	simSetInterruptHandler(NULL);
+}
+#endif
+int main(void)
+{
+	testTune();
+	testScan();
+	testAmScan();
+	testSeek();
+	testRds();
+	testRdsFastPoll();
+	testPatch();
+	testResidentPatch();
+	testProperties();
+	testInterrupt();
+	testBackgroundScan();
+	testRdsText();
+	testRdsCache();
+	testAfSwitch();
+	testCapture();
+#ifdef SI473X_MULTI_DEVICE
+	testContexts();
+#endif
+	printf("%d failure(s)\n", failures);
+	return failures != 0;
+}
\ No newline at end of file
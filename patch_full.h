@@ -19,6 +19,8 @@
  * 0x16 = 22 (00010110); 0x01 = 1 (00000001); 0xFF = 255 (11111111);
  */
 
+#define SSB_PATCH_CRC 0xDF63 // CRC-16/CCITT-FALSE of ssb_patch_content (tools/patch_crc.py)
+
 // SSB patch for whole SSBRX full download
 const uint8_t ssb_patch_content[] =
     {   0x15, 0x00, 0x0F, 0xE0, 0xF2, 0x73, 0x76, 0x2F,
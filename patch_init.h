@@ -18,6 +18,8 @@
  * the supplied hexadecimal constants into their numerical equivalents. For example: 0x15 = 21 (00010101);
  * 0x16 = 22 (00010110); 0x01 = 1 (00000001); 0xFF = 255 (11111111);
  */
+#define SSB_PATCH_CRC 0xB83E // CRC-16/CCITT-FALSE of ssb_patch_content (tools/patch_crc.py)
+
 // SSB patch for whole SSBRX initialization string
 // You can remove PROGMEM if you have enough RAM memory 
 const uint8_t ssb_patch_content[] =
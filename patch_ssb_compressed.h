@@ -21,7 +21,8 @@
   patch begin with 0x16, so only the lines which begin with 0x15 are stored. 
   This approach saves about 1K of memory.
 
-  See downloadCompressedPatch implementation in the SI4735.cpp file for more details. 
+  See downloadCompressedPatch implementation in the SI4735.c file for more details. The cmd_0x15 array
+  must be in ascending order. tools/patch_compress.py builds both arrays from patch_init.h or patch_full.h.
 
   The example code below shows how to use compressed SSB patch.
 
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Builds a compressed SSB patch header (see patch_ssb_compressed.h) from patch_init.h or patch_full.h.
+
+The first byte (0x15 or 0x16) of each 8 bytes patch line is removed. The numbers of the lines that
+begin with 0x15 are stored, in ascending order, in the cmd_0x15 array. downloadCompressedPatch walks
+that array with a cursor, so it finds the first byte of each line in constant time.
+
+Usage:
+    python3 tools/patch_compress.py patch_init.h > my_patch_compressed.h
+"""
+
+import re
+import sys
+
+
+def read_patch(path):
+    """Returns the bytes of the ssb_patch_content array of a patch header."""
+    with open(path) as f:
+        text = f.read()
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", "", text)
+    body = re.search(r"ssb_patch_content\s*\[\s*\]\s*=\s*\{(.*?)\}", text, re.S)
+    if body is None:
+        sys.exit("%s: ssb_patch_content array not found" % path)
+    data = [int(v, 0) for v in re.findall(r"0x[0-9A-Fa-f]+|\d+", body.group(1))]
+    if len(data) % 8:
+        sys.exit("%s: the patch size (%d) is not a multiple of 8" % (path, len(data)))
+    return data
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), the same as patchCrc16 in SI4735.c."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def compress(data):
+    """Splits the patch into the cmd_0x15 line list and the 7 bytes lines."""
+    cmd_0x15 = []
+    content = []
+    for line in range(len(data) // 8):
+        cmd = data[line * 8]
+        if cmd == 0x15:
+            cmd_0x15.append(line)
+        elif cmd != 0x16:
+            sys.exit("line %d: unexpected command 0x%02X" % (line, cmd))
+        content.extend(data[line * 8 + 1:line * 8 + 8])
+    return cmd_0x15, content
+
+
+def emit(source, cmd_0x15, content):
+    out = []
+    out.append("/*")
+    out.append("  Compressed SSB patch generated by tools/patch_compress.py from %s." % source)
+    out.append("  See patch_ssb_compressed.h and downloadCompressedPatch (SI4735.c).")
+    out.append("")
+    out.append("  const uint16_t size_content = sizeof ssb_patch_content;")
+    out.append("  const uint16_t cmd_0x15_size = sizeof cmd_0x15;")
+    out.append("  downloadCompressedPatch(ssb_patch_content, size_content, cmd_0x15, cmd_0x15_size);")
+    out.append("*/")
+    out.append("")
+    out.append("// Lines that begin with 0x15 (ascending order). The other lines begin with 0x16.")
+    out.append("const uint16_t cmd_0x15[] = {")
+    for i in range(0, len(cmd_0x15), 16):
+        out.append("    " + ", ".join("%4d" % v for v in cmd_0x15[i:i + 16]) + ("," if i + 16 < len(cmd_0x15) else "};"))
+    out.append("")
+    out.append("const uint8_t ssb_patch_content[] = {")
+    for i in range(0, len(content), 7):
+        out.append("    " + ", ".join("0x%02X" % v for v in content[i:i + 7]) + ("," if i + 7 < len(content) else "};"))
+    return "\n".join(out) + "\n"
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    data = read_patch(sys.argv[1])
+    cmd_0x15, content = compress(data)
+    sys.stdout.write(emit(sys.argv[1], cmd_0x15, content))
+    sys.stderr.write("%d lines, %d lines with 0x15, %d -> %d bytes\n"
+                     % (len(data) // 8, len(cmd_0x15), len(data), len(content) + 2 * len(cmd_0x15)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,25 @@
+#!/usr/bin/env python3
+"""
+Prints the CRC of the ssb_patch_content array of a patch header (patch_init.h or patch_full.h).
+
+Paste the output into the patch header. downloadPatchChecked (SI4735.c) checks the array against it
+before the download.
+
+Usage:
+    python3 tools/patch_crc.py patch_full.h
+"""
+
+import sys
+
+from patch_compress import crc16, read_patch
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    data = read_patch(sys.argv[1])
+    print("#define SSB_PATCH_CRC 0x%04X // CRC-16/CCITT-FALSE of ssb_patch_content (tools/patch_crc.py)" % crc16(data))
+
+
+if __name__ == "__main__":
+    main()
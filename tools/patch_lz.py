@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Builds an LZ compressed SSB patch header from patch_init.h or patch_full.h (see downloadLzPatch in SI4735.c).
+
+Container (all multi-byte numbers are little-endian):
+    byte 0       format version (SI473X_LZ_PATCH_VERSION = 1)
+    bytes 1-2    number of 8 bytes patch lines
+    bytes 3-4    number of lines that begin with 0x15
+    ...          gaps between the lines that begin with 0x15 (the first one is the line number itself)
+    ...          LZ sequences that rebuild the 7 bytes that follow the 0x15/0x16 byte of each line:
+                 token (literals << 4 | match length - 3), [literal length], literals,
+                 [offset (1-255), [match length]]. A 4-bit length of 15 is followed by the rest
+                 of the length. The last sequence has no match.
+    Gaps and lengths are stored 7 bits per byte, least significant first (bit 7 = more bytes follow).
+
+The decoder needs just a 256 bytes window, so the patch is never stored in RAM.
+
+Usage:
+    python3 tools/patch_lz.py patch_init.h > patch_init_lz.h
+"""
+
+import sys
+
+from patch_compress import compress, crc16, read_patch
+
+VERSION = 1
+WINDOW = 255
+MIN_MATCH = 3
+
+
+def put_length(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def encode(data):
+    cmd_0x15, content = compress(data)
+    out = [VERSION, (len(data) // 8) & 0xFF, (len(data) // 8) >> 8, len(cmd_0x15) & 0xFF, len(cmd_0x15) >> 8]
+    last = 0
+    for line in cmd_0x15:
+        put_length(out, line - last)
+        last = line
+
+    i = 0
+    literals = []
+    while i <= len(content):
+        best, offset = 0, 0
+        if i < len(content):
+            for j in range(max(0, i - WINDOW), i):
+                n = 0
+                while i + n < len(content) and content[j + n] == content[i + n]:
+                    n += 1
+                if n > best:
+                    best, offset = n, i - j
+        if best < MIN_MATCH and i < len(content):
+            literals.append(content[i])
+            i += 1
+            continue
+        last_sequence = i >= len(content)
+        match = 0 if last_sequence else best - MIN_MATCH
+        out.append((min(len(literals), 15) << 4) | min(match, 15))
+        if len(literals) >= 15:
+            put_length(out, len(literals) - 15)
+        out.extend(literals)
+        literals = []
+        if last_sequence:
+            break
+        out.append(offset)
+        if match >= 15:
+            put_length(out, match - 15)
+        i += best
+    return out
+
+
+def decode(packed):
+    """Reference decoder (used to check the encoder output)."""
+    pos = 5
+    lines = packed[1] | packed[2] << 8
+    count = packed[3] | packed[4] << 8
+
+    def get_varint():
+        nonlocal pos
+        value, shift = 0, 0
+        while True:
+            b = packed[pos]
+            pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def get_length(value):
+        return value + get_varint() if value == 15 else value
+
+    cmd_0x15 = []
+    line = 0
+    for _ in range(count):
+        line += get_varint()
+        cmd_0x15.append(line)
+    content = []
+    while len(content) < lines * 7:
+        token = packed[pos]
+        pos += 1
+        n = get_length(token >> 4)
+        content.extend(packed[pos:pos + n])
+        pos += n
+        if len(content) >= lines * 7:
+            break
+        offset = packed[pos]
+        pos += 1
+        n = get_length(token & 15) + MIN_MATCH
+        for _ in range(n):
+            content.append(content[-offset])
+    data = []
+    for i in range(lines):
+        data.append(0x15 if i in cmd_0x15 else 0x16)
+        data.extend(content[i * 7:i * 7 + 7])
+    return data
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    data = read_patch(sys.argv[1])
+    packed = encode(data)
+    if decode(packed) != data:
+        sys.exit("internal error: the LZ stream does not rebuild the patch")
+    out = ["/*",
+           "  LZ compressed SSB patch generated by tools/patch_lz.py from %s." % sys.argv[1],
+           "  See downloadLzPatch and loadLzPatch (SI4735.c).",
+           "",
+           "  loadLzPatch(ssb_patch_lz, sizeof ssb_patch_lz, 0);",
+           "*/",
+           "",
+           "#define SSB_PATCH_LZ_CRC 0x%04X // CRC-16/CCITT-FALSE of ssb_patch_lz (see downloadLzPatchChecked)" % crc16(packed),
+           "",
+           "const uint8_t ssb_patch_lz[] = {"]
+    for i in range(0, len(packed), 16):
+        out.append("    " + ", ".join("0x%02X" % v for v in packed[i:i + 16]) + ("," if i + 16 < len(packed) else "};"))
+    sys.stdout.write("\n".join(out) + "\n")
+    cmd_0x15, content = compress(data)
+    sys.stderr.write("%d bytes -> %d bytes (compressed header format: %d bytes)\n"
+                     % (len(data), len(packed), len(content) + 2 * len(cmd_0x15)))
+
+
+if __name__ == "__main__":
+    main()